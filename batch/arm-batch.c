@@ -0,0 +1,746 @@
+/*
+ * ARMv7T -- lock-step batch executor
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs the same executable on many inputs in one process. Each input is a
+ * lane with its own platform (memory) and state. The lanes are executed in
+ * lock-step: at each round, the lanes are grouped by (PC, instruction set)
+ * and the instruction of a group is executed on each of its lanes. The
+ * groups are rebuilt after each round, so that diverging lanes split and
+ * reconverging lanes merge again. The decoded instructions are kept in a
+ * direct-mapped cache indexed by the same key, so that a loop is decoded
+ * once for the whole batch; a miss is decoded with the table of the
+ * instruction set of the lane (see extern/iset.h).
+ *
+ * The keys of the lanes are held in a structure-of-arrays (key[], lane[])
+ * and sorted with a linear counting sort. The registers of the lanes are
+ * also kept as structure-of-arrays (soa_gpr[16][K], soa_apsr[K] for K lanes)
+ * and the ARM data-processing instructions (AND, EOR, SUB, RSB, ADD, TST,
+ * TEQ, CMP, CMN, ORR, MOV, BIC, MVN with an immediate or a register shifted
+ * by an immediate, registers other than PC) and B are executed on the lanes
+ * of a group VEC at a time with host vectors: the condition, the shifter and
+ * the flags are computed for all the lanes and blended in. The other
+ * instructions run the generated semantics (arm_execute()) lane by lane: the
+ * registers of a lane live either in the arrays or in its state and are
+ * moved on demand. The vector path is left out when arm_execute() has a
+ * per-instruction hook (EXN = in, statistics, timing, trace, profile, BBV,
+ * coverage, cache or probe) and with -n. ADC, SBC and RSC are not vectorized:
+ * their generated semantics read the carry after the shifter updated it.
+ *
+ * The input of a lane is copied in the guest buffer batch_input (at most
+ * the size of the symbol) and its size in the word batch_input_size, when
+ * the executable defines them. Both must be initialized variables (.data):
+ * the start-up code of the guest clears the .bss after the loading. A lane stops when it reaches _exit, its exit
+ * code being r0, or after the maximum number of instructions (-m). A direct
+ * exit system call (without _exit) stops the whole batch.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arm/api.h>
+#include <arm/config.h>
+#include <arm/loader.h>
+#include <arm/mem.h>
+
+/* instruction set bit of APSR */
+#define THUMB_BIT	(1 << 5)
+
+/* vector execution of the lanes (see above) */
+#if !defined(ARM_EXN_IN) && !defined(ARM_STATS) && !defined(ARM_TIMING) && !defined(ARM_TRACE) \
+ && !defined(ARM_PROFILE) && !defined(ARM_BBV) && !defined(ARM_COVER) && !defined(ARM_CACHE) \
+ && !defined(arm_probe_inst)
+#	define SIMD_OK	1
+#else
+#	define SIMD_OK	0
+#endif
+
+/* lanes by host vector */
+#define VEC			4
+typedef uint32_t vec_t __attribute__((vector_size(VEC * sizeof(uint32_t)), may_alias));
+typedef int32_t vmask_t __attribute__((vector_size(VEC * sizeof(int32_t)), may_alias));
+
+/* size of the decoding cache (power of 2) */
+#define DCACHE_SIZE	4096
+
+/* options */
+uint64_t max_steps = 0;
+const char *out_path = NULL;
+int simd = SIMD_OK;
+
+/* lanes */
+typedef struct lane_t {
+	const char *input;
+	arm_platform_t *pf;
+	arm_state_t *state;
+	uint64_t steps;
+	int code;
+} lane_t;
+lane_t *lanes;
+int lane_cnt;
+
+/* structure-of-arrays of the running lanes (current and next round) */
+uint32_t *key, *nkey;
+int *order, *norder;
+int run_cnt;
+
+/* grouping table (open addressing, key -> group) */
+uint32_t *tab_key;
+int *tab_grp, *grp_cnt;
+int tab_mask;
+
+/* guest symbols */
+arm_address_t exit_addr, input_addr, input_size_addr;
+uint32_t input_max;
+
+/* registers of the lanes as structure-of-arrays (padded to VEC lanes),
+ * valid for the lanes with resident[] set, the state being valid else;
+ * soa_act[] marks the lanes of the group being executed */
+uint32_t *soa_gpr[16], *soa_apsr, *soa_sbit, *soa_act;
+uint8_t *resident;
+
+/* vectorized instructions */
+typedef enum {
+	ALU_NONE = 0,		/* executed lane by lane */
+	ALU_DP,				/* data-processing */
+	ALU_B				/* branch */
+} alu_kind_t;
+enum { OP_AND = 0, OP_EOR, OP_SUB, OP_RSB, OP_ADD, OP_ADC, OP_SBC, OP_RSC,
+	OP_TST, OP_TEQ, OP_CMP, OP_CMN, OP_ORR, OP_MOV, OP_BIC, OP_MVN };
+enum { SH_LSL = 0, SH_LSR, SH_ASR, SH_ROR };
+typedef struct alu_t {
+	uint8_t kind;
+	uint8_t op, cond, s;
+	uint8_t rd, rn, rm;		/* rm = 16 for an immediate */
+	uint8_t shift, amount;
+	uint32_t imm;			/* rotated immediate or branch offset */
+	int8_t imm_carry;		/* carry of the immediate, -1 for unchanged */
+} alu_t;
+
+/* decoding cache (key -> instruction) */
+uint32_t dc_key[DCACHE_SIZE];
+arm_inst_t *dc_inst[DCACHE_SIZE];
+alu_t dc_alu[DCACHE_SIZE];
+
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: arm-batch [-m STEPS] [-n] [-o OUTPUT] EXECUTABLE INPUT...\n"
+		"\t-m STEPS\tstop a lane after STEPS instructions\n"
+		"\t-n\texecute all the instructions lane by lane (no vectors)\n"
+		"\t-o OUTPUT\twrite the results (CSV) to OUTPUT (default standard output)\n");
+}
+
+
+/**
+ * Move the registers of a lane from its state to the arrays.
+ * @param i		Lane index.
+ */
+static void to_soa(int i) {
+	arm_state_t *s = lanes[i].state;
+	int r;
+	for(r = 0; r < 16; r++)
+		soa_gpr[r][i] = s->GPR[r];
+	soa_apsr[i] = s->APSR;
+	soa_sbit[i] = s->SBIT;
+	resident[i] = 1;
+}
+
+
+/**
+ * Move the registers of a lane from the arrays to its state.
+ * @param i		Lane index.
+ */
+static void to_state(int i) {
+	arm_state_t *s = lanes[i].state;
+	int r;
+	for(r = 0; r < 16; r++)
+		s->GPR[r] = soa_gpr[r][i];
+	s->APSR = soa_apsr[i];
+	s->SBIT = soa_sbit[i];
+	resident[i] = 0;
+}
+
+
+/**
+ * Get the PC of a lane.
+ * @param i		Lane index.
+ * @return		PC of the lane.
+ */
+static inline uint32_t pc_of(int i) {
+	return resident[i] ? soa_gpr[15][i] : lanes[i].state->GPR[15];
+}
+
+
+/**
+ * Build the key of a lane.
+ * @param i		Lane index.
+ * @return		PC with the instruction set in bit 0.
+ */
+static inline uint32_t key_of(int i) {
+	uint32_t apsr = resident[i] ? soa_apsr[i] : lanes[i].state->APSR;
+	return pc_of(i) | ((apsr & THUMB_BIT) != 0);
+}
+
+
+/**
+ * Copy the input file of a lane in its guest memory.
+ * @param l		Lane to initialize.
+ * @return		0 for success, -1 else (error displayed).
+ */
+int load_input(lane_t *l) {
+	arm_memory_t *mem = arm_get_memory(l->pf, ARM_MAIN_MEMORY);
+	FILE *in;
+	uint32_t n = 0;
+	int c;
+
+	in = fopen(l->input, "rb");
+	if(in == NULL) {
+		fprintf(stderr, "ERROR: cannot open %s\n", l->input);
+		return -1;
+	}
+	if(input_addr != 0)
+		while(n < input_max && (c = fgetc(in)) != EOF)
+			arm_mem_write8(mem, input_addr + n++, c);
+	if(!feof(in) && fgetc(in) != EOF)
+		fprintf(stderr, "WARNING: %s truncated to %u bytes\n", l->input, n);
+	fclose(in);
+	if(input_size_addr != 0)
+		arm_mem_write32(mem, input_size_addr, n);
+	return 0;
+}
+
+
+/**
+ * Group the running lanes by key: order is rebuilt so that the lanes
+ * with the same key are contiguous; grp_cnt[g] gives the size of group g.
+ * @return	Number of groups.
+ */
+int group(void) {
+	int i, j, g, n = 0, *t;
+	uint32_t *tk;
+
+	/* number the keys */
+	for(i = 0; i < run_cnt; i++) {
+		uint32_t k = key[i];
+		for(j = (k * 0x9e3779b1) >> 7 & tab_mask; tab_grp[j] >= 0 && tab_key[j] != k; j = (j + 1) & tab_mask)
+			;
+		if(tab_grp[j] < 0) {
+			tab_key[j] = k;
+			tab_grp[j] = n;
+			grp_cnt[n++] = 0;
+		}
+		grp_cnt[tab_grp[j]]++;
+		nkey[i] = j;
+	}
+
+	/* counting sort */
+	for(g = 0, j = 0; g < n; g++) {
+		int c = grp_cnt[g];
+		grp_cnt[g] = j;
+		j += c;
+	}
+	for(i = 0; i < run_cnt; i++) {
+		g = tab_grp[nkey[i]];
+		norder[grp_cnt[g]++] = order[i];
+	}
+	for(g = n - 1; g > 0; g--)
+		grp_cnt[g] -= grp_cnt[g - 1];
+	for(i = 0; i < run_cnt; i++)
+		tab_grp[nkey[i]] = -1;
+	for(i = 0; i < run_cnt; i++)
+		nkey[i] = key_of(norder[i]);
+
+	/* swap arrays */
+	t = order; order = norder; norder = t;
+	tk = key; key = nkey; nkey = tk;
+	return n;
+}
+
+
+/**
+ * Find if an ARM opcode can be executed with vectors, following the
+ * encodings of nmp/dataProcessing.nmp and B_Cond in nmp/control.nmp.
+ * @param w		Opcode.
+ * @param a		Filled with the description (kind ALU_NONE if it cannot).
+ */
+static void classify(uint32_t w, alu_t *a) {
+	uint32_t rot;
+
+	memset(a, 0, sizeof(alu_t));
+	a->cond = w >> 28;
+	if(a->cond == 15)
+		return;
+
+	/* B */
+	if(((w >> 24) & 0xf) == 0xa) {
+		a->kind = ALU_B;
+		a->imm = (uint32_t)((int32_t)(w << 8) >> 6);
+		return;
+	}
+
+	/* data-processing with immediate or immediate shift */
+	if(((w >> 26) & 3) != 0 || (!(w & (1 << 25)) && (w & (1 << 4))))
+		return;
+	a->op = (w >> 21) & 0xf;
+	a->s = (w >> 20) & 1;
+	a->rn = (w >> 16) & 0xf;
+	a->rd = (w >> 12) & 0xf;
+	switch(a->op) {
+	case OP_ADC: case OP_SBC: case OP_RSC:
+		return;
+	case OP_TST: case OP_TEQ: case OP_CMP: case OP_CMN:
+		if(!a->s || a->rd != 0 || a->rn == 15)
+			return;
+		break;
+	case OP_MOV: case OP_MVN:
+		if(a->rn != 0 || a->rd == 15)
+			return;
+		break;
+	default:
+		if(a->rn == 15 || a->rd == 15)
+			return;
+		break;
+	}
+	if(w & (1 << 25)) {
+		rot = ((w >> 8) & 0xf) << 1;
+		a->rm = 16;
+		a->imm = rot == 0 ? (w & 0xff) : ((w & 0xff) >> rot) | ((w & 0xff) << (32 - rot));
+		a->imm_carry = rot == 0 ? -1 : a->imm >> 31;
+	}
+	else {
+		a->rm = w & 0xf;
+		if(a->rm == 15)
+			return;
+		a->shift = (w >> 5) & 3;
+		a->amount = (w >> 7) & 0x1f;
+	}
+	a->kind = ALU_DP;
+}
+
+
+/**
+ * Get the decoded instruction of a key from the decoding cache.
+ * @param d		Decoder.
+ * @param l		Lane with this key.
+ * @param k		Key (PC and instruction set).
+ * @param alu	Set to the description for the vector execution.
+ * @return		Decoded instruction.
+ */
+static arm_inst_t *decode(arm_decoder_t *d, lane_t *l, uint32_t k, alu_t **alu) {
+	int i = (k >> 1) & (DCACHE_SIZE - 1);
+	if(dc_inst[i] == NULL || dc_key[i] != k) {
+		if(dc_inst[i] != NULL)
+			arm_free_inst(dc_inst[i]);
+		if(arm_modes[0].name != NULL)
+			dc_inst[i] = arm_modes[l->state->iset].decode(d, k & ~1);
+		else {
+			arm_set_cond_state(d, l->state);
+			dc_inst[i] = arm_decode(d, k & ~1);
+		}
+		dc_key[i] = k;
+		if(simd && !(k & 1))
+			classify(arm_mem_read32(arm_get_memory(l->pf, ARM_MAIN_MEMORY), k), &dc_alu[i]);
+		else
+			dc_alu[i].kind = ALU_NONE;
+	}
+	*alu = &dc_alu[i];
+	return dc_inst[i];
+}
+
+
+/**
+ * Compute the condition of an instruction for a vector of lanes.
+ * @param cond	Condition code.
+ * @param ap	APSR of the lanes.
+ * @return		Mask of the lanes passing the condition.
+ */
+static inline vmask_t cond_mask(int cond, vec_t ap) {
+	vmask_t n = (vmask_t)ap < 0, z = (vmask_t)(ap << 1) < 0,
+		c = (vmask_t)(ap << 2) < 0, v = (vmask_t)(ap << 3) < 0, m;
+	switch(cond >> 1) {
+	case 0:		m = z; break;
+	case 1:		m = c; break;
+	case 2:		m = n; break;
+	case 3:		m = v; break;
+	case 4:		m = c & ~z; break;
+	case 5:		m = ~(n ^ v); break;
+	case 6:		m = ~(n ^ v) & ~z; break;
+	default:	return n | ~n;
+	}
+	return cond & 1 ? ~m : m;
+}
+
+
+/**
+ * Execute a vectorized instruction on the lanes marked in soa_act[]
+ * between lo and hi.
+ * @param a		Instruction.
+ * @param lo	First lane.
+ * @param hi	Last lane + 1.
+ */
+static void exec_vec(const alu_t *a, int lo, int hi) {
+	const vec_t zero = { 0 }, top = zero + 0x80000000, pcn = zero + 4;
+	int base;
+
+	for(base = lo & ~(VEC - 1); base < hi; base += VEC) {
+		vec_t *pc = (vec_t *)&soa_gpr[15][base], *apsr = (vec_t *)&soa_apsr[base];
+		vec_t ap = *apsr, rn, op2, res, nf;
+		vmask_t in = *(vmask_t *)&soa_act[base], pass, cy, c, n, z, v, sb;
+
+		pass = in & cond_mask(a->cond, ap);
+		c = (vmask_t)(ap << 2) < 0;
+
+		/* branch */
+		if(a->kind == ALU_B) {
+			*pc += (vec_t)(in & (vmask_t)pcn) + (vec_t)(pass & (vmask_t)(zero + 4 + a->imm));
+			continue;
+		}
+
+		/* shifter */
+		if(a->rm == 16) {
+			op2 = zero + a->imm;
+			if(a->imm_carry < 0)
+				cy = c;
+			else
+				cy = (vmask_t)(zero - a->imm_carry);
+		}
+		else {
+			vec_t rm = *(vec_t *)&soa_gpr[a->rm][base];
+			int k = a->amount;
+			switch(a->shift) {
+			case SH_LSL:
+				if(k == 0) {
+					op2 = rm;
+					cy = c;
+				}
+				else {
+					op2 = rm << k;
+					cy = (vmask_t)(rm << (k - 1)) < 0;
+				}
+				break;
+			case SH_LSR:
+				if(k == 0) {
+					op2 = zero;
+					cy = (vmask_t)rm < 0;
+				}
+				else {
+					op2 = rm >> k;
+					cy = -(vmask_t)((rm >> (k - 1)) & 1);
+				}
+				break;
+			case SH_ASR:
+				if(k == 0) {
+					op2 = (vec_t)((vmask_t)rm >> 31);
+					cy = (vmask_t)rm < 0;
+				}
+				else {
+					op2 = (vec_t)((vmask_t)rm >> k);
+					cy = -(vmask_t)((rm >> (k - 1)) & 1);
+				}
+				break;
+			default:
+				if(k == 0) {
+					op2 = ((vec_t)c & top) | (rm >> 1);
+					cy = -(vmask_t)(rm & 1);
+				}
+				else {
+					op2 = (rm >> k) | (rm << (32 - k));
+					cy = -(vmask_t)((rm >> (k - 1)) & 1);
+				}
+				break;
+			}
+		}
+
+		/* operation */
+		rn = *(vec_t *)&soa_gpr[a->rn][base];
+		v = (vmask_t)(ap << 3) < 0;
+		switch(a->op) {
+		case OP_AND: case OP_TST:	res = rn & op2; break;
+		case OP_EOR: case OP_TEQ:	res = rn ^ op2; break;
+		case OP_ORR:				res = rn | op2; break;
+		case OP_BIC:				res = rn & ~op2; break;
+		case OP_MOV:				res = op2; break;
+		case OP_MVN:				res = ~op2; break;
+		case OP_SUB: case OP_CMP:
+			res = rn - op2;
+			cy = rn >= op2;
+			v = (vmask_t)((rn ^ op2) & (rn ^ res)) < 0;
+			break;
+		case OP_RSB:
+			res = op2 - rn;
+			cy = op2 >= rn;
+			v = (vmask_t)((op2 ^ rn) & (op2 ^ res)) < 0;
+			break;
+		default:
+			res = rn + op2;
+			cy = res < rn;
+			v = (vmask_t)((rn ^ res) & (op2 ^ res)) < 0;
+			break;
+		}
+
+		/* flags: the compares also take the shifter carry from the last
+		 * S bit, as update_shift_CFLAG() in the generated semantics */
+		if(a->op == OP_TST || a->op == OP_TEQ) {
+			sb = *(vmask_t *)&soa_sbit[base] != 0;
+			cy = (sb & cy) | (~sb & c);
+		}
+		if(a->s) {
+			n = (vmask_t)res < 0;
+			z = res == zero;
+			nf = (ap & 0x0fffffff) | ((vec_t)n & top) | ((vec_t)z & (top >> 1))
+				| ((vec_t)cy & (top >> 2)) | ((vec_t)v & (top >> 3));
+			*apsr = (nf & (vec_t)pass) | (ap & ~(vec_t)pass);
+		}
+
+		/* results */
+		if(a->op < OP_TST || a->op > OP_CMN) {
+			vec_t *rd = (vec_t *)&soa_gpr[a->rd][base], *sb = (vec_t *)&soa_sbit[base];
+			*rd = (res & (vec_t)pass) | (*rd & ~(vec_t)pass);
+			*sb = ((zero + a->s) & (vec_t)pass) | (*sb & ~(vec_t)pass);
+		}
+		*pc += (vec_t)(in & (vmask_t)pcn);
+	}
+}
+
+
+/**
+ * Execute a vectorized instruction on the lanes of a group.
+ * @param a		Instruction.
+ * @param b		First slot of the group in order[].
+ * @param e		Last slot + 1.
+ */
+static void exec_group(const alu_t *a, int b, int e) {
+	int i, lo = lane_cnt, hi = 0;
+	for(i = b; i < e; i++) {
+		int l = order[i];
+		if(!resident[l])
+			to_soa(l);
+		soa_act[l] = 0xffffffff;
+		if(l < lo)
+			lo = l;
+		if(l >= hi)
+			hi = l + 1;
+	}
+	exec_vec(a, lo, hi);
+	for(i = b; i < e; i++)
+		soa_act[order[i]] = 0;
+}
+
+
+/**
+ * Run all lanes to their end.
+ * @param d		Decoder (shared by the lanes).
+ */
+void run(arm_decoder_t *d) {
+	int g, n, i, b, e;
+
+	while(run_cnt > 0) {
+		n = group();
+
+		/* execute each group */
+		for(g = 0, b = 0; g < n; g++, b = e) {
+			arm_inst_t *inst;
+			alu_t *alu;
+			e = b + grp_cnt[g];
+			inst = decode(d, &lanes[order[b]], key[b], &alu);
+			if(alu->kind != ALU_NONE) {
+				exec_group(alu, b, e);
+				for(i = b; i < e; i++)
+					lanes[order[i]].steps++;
+			}
+			else
+				for(i = b; i < e; i++) {
+					lane_t *l = &lanes[order[i]];
+					if(resident[order[i]])
+						to_state(order[i]);
+					arm_execute(l->state, inst);
+					l->steps++;
+				}
+		}
+
+		/* remove the ended lanes */
+		for(i = 0, e = 0; i < run_cnt; i++) {
+			lane_t *l = &lanes[order[i]];
+			if(pc_of(order[i]) == exit_addr || (max_steps != 0 && l->steps >= max_steps)) {
+				if(resident[order[i]])
+					to_state(order[i]);
+				l->code = l->state->GPR[15] == exit_addr ? (int)l->state->GPR[0] : -1;
+			}
+			else {
+				key[e] = key_of(order[i]);
+				order[e++] = order[i];
+			}
+		}
+		run_cnt = e;
+	}
+
+	/* release the decoding cache */
+	for(i = 0; i < DCACHE_SIZE; i++)
+		if(dc_inst[i] != NULL) {
+			arm_free_inst(dc_inst[i]);
+			dc_inst[i] = NULL;
+		}
+}
+
+
+/**
+ * Command entry point.
+ */
+int main(int argc, char **argv) {
+	arm_loader_t *loader;
+	arm_decoder_t *d;
+	FILE *out = stdout;
+	int opt, i, cnt, size;
+
+	/* parse arguments */
+	while((opt = getopt(argc, argv, "m:no:h")) != -1)
+		switch(opt) {
+		case 'm':	max_steps = strtoull(optarg, NULL, 0); break;
+		case 'n':	simd = 0; break;
+		case 'o':	out_path = optarg; break;
+		default:	usage(); return 1;
+		}
+	if(optind + 2 > argc) {
+		usage();
+		return 1;
+	}
+	lane_cnt = argc - optind - 1;
+
+	/* look for the symbols */
+	loader = arm_loader_open(argv[optind]);
+	if(loader == NULL) {
+		fprintf(stderr, "ERROR: cannot load the executable \"%s\"\n", argv[optind]);
+		return 2;
+	}
+	cnt = arm_loader_count_syms(loader);
+	for(i = 0; i < cnt; i++) {
+		arm_loader_sym_t sym;
+		arm_loader_sym(loader, i, &sym);
+		if(strcmp(sym.name, "_exit") == 0)
+			exit_addr = sym.value & ~1;
+		else if(strcmp(sym.name, "batch_input") == 0) {
+			input_addr = sym.value;
+			input_max = sym.size;
+		}
+		else if(strcmp(sym.name, "batch_input_size") == 0)
+			input_size_addr = sym.value;
+	}
+	if(exit_addr == 0) {
+		fprintf(stderr, "ERROR: no _exit in %s\n", argv[optind]);
+		return 2;
+	}
+
+	/* allocate the arrays */
+	for(size = 1; size < 2 * lane_cnt; size <<= 1)
+		;
+	tab_mask = size - 1;
+	lanes = calloc(lane_cnt, sizeof(lane_t));
+	key = malloc(lane_cnt * sizeof(uint32_t));
+	nkey = malloc(lane_cnt * sizeof(uint32_t));
+	order = malloc(lane_cnt * sizeof(int));
+	norder = malloc(lane_cnt * sizeof(int));
+	grp_cnt = malloc(lane_cnt * sizeof(int));
+	tab_key = malloc(size * sizeof(uint32_t));
+	tab_grp = malloc(size * sizeof(int));
+	if(lanes == NULL || key == NULL || nkey == NULL || order == NULL || norder == NULL
+	|| grp_cnt == NULL || tab_key == NULL || tab_grp == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	memset(tab_grp, 0xff, size * sizeof(int));
+	size = (lane_cnt + VEC - 1) & ~(VEC - 1);
+	for(i = 0; i < 16; i++)
+		soa_gpr[i] = aligned_alloc(sizeof(vec_t), size * sizeof(uint32_t));
+	soa_apsr = aligned_alloc(sizeof(vec_t), size * sizeof(uint32_t));
+	soa_sbit = aligned_alloc(sizeof(vec_t), size * sizeof(uint32_t));
+	soa_act = aligned_alloc(sizeof(vec_t), size * sizeof(uint32_t));
+	resident = calloc(lane_cnt, 1);
+	if(soa_apsr == NULL || soa_sbit == NULL || soa_act == NULL || resident == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	for(i = 0; i < 16; i++) {
+		if(soa_gpr[i] == NULL) {
+			fprintf(stderr, "ERROR: no more resources\n");
+			return 2;
+		}
+		memset(soa_gpr[i], 0, size * sizeof(uint32_t));
+	}
+	memset(soa_apsr, 0, size * sizeof(uint32_t));
+	memset(soa_sbit, 0, size * sizeof(uint32_t));
+	memset(soa_act, 0, size * sizeof(uint32_t));
+
+	/* build the lanes */
+	for(i = 0; i < lane_cnt; i++) {
+		lane_t *l = &lanes[i];
+		l->input = argv[optind + 1 + i];
+		l->pf = arm_new_platform();
+		if(l->pf == NULL) {
+			fprintf(stderr, "ERROR: no more resources\n");
+			return 2;
+		}
+		arm_load(l->pf, loader);
+		if(load_input(l) != 0)
+			return 2;
+		l->state = arm_new_state(l->pf);
+		if(l->state == NULL) {
+			fprintf(stderr, "ERROR: no more resources\n");
+			return 2;
+		}
+		arm_iset_update(l->state);
+		key[i] = key_of(i);
+		order[i] = i;
+	}
+	run_cnt = lane_cnt;
+	arm_loader_close(loader);
+
+	/* run them */
+	d = arm_new_decoder(lanes[0].pf);
+	if(d == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	run(d);
+	arm_delete_decoder(d);
+
+	/* output the results */
+	if(out_path != NULL) {
+		out = fopen(out_path, "w");
+		if(out == NULL) {
+			fprintf(stderr, "ERROR: cannot create %s\n", out_path);
+			return 2;
+		}
+	}
+	fprintf(out, "input,code,instructions\n");
+	for(i = 0; i < lane_cnt; i++)
+		fprintf(out, "%s,%d,%llu\n", lanes[i].input, lanes[i].code, (unsigned long long)lanes[i].steps);
+	if(out != stdout)
+		fclose(out);
+
+	/* cleanup */
+	for(i = 0; i < lane_cnt; i++) {
+		arm_delete_state(lanes[i].state);
+		arm_unlock_platform(lanes[i].pf);
+	}
+	return 0;
+}
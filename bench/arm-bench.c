@@ -0,0 +1,160 @@
+/*
+ * ARMv7T -- benchmark runner
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs an executable as arm-sim does, counting the executed instructions,
+ * and outputs a JSON object with the instruction count, the time, the MIPS,
+ * the time per instruction and the peak resident set size of the process.
+ *
+ * The guest normally ends with the exit system call that exits the host
+ * process: the results are then output by an atexit() handler and the exit
+ * code of arm-bench is the one of the guest.
+ *
+ * With WITH_FUSION, a step may execute a fused pair: the hits of the fusion
+ * are added to the steps so that the instruction count and the MIPS remain
+ * comparable with the other builds. The counters are read when the guest
+ * reaches _exit, so an executable without _exit is refused.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <arm/api.h>
+#include <arm/loader.h>
+
+/* results */
+const char *name;
+FILE *out;
+uint64_t steps = 0;
+struct timespec t0;
+
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: arm-bench [-o OUTPUT] NAME EXECUTABLE\n"
+		"\t-o OUTPUT\twrite the results (JSON) to OUTPUT (default standard error)\n");
+}
+
+
+/**
+ * Output the results (called at exit).
+ */
+void report(void) {
+	struct timespec t1;
+	struct rusage ru;
+	double s;
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	getrusage(RUSAGE_SELF, &ru);
+	s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+	fprintf(out, "{ \"name\": \"%s\", \"instructions\": %llu, \"seconds\": %.3f, "
+		"\"mips\": %.2f, \"ns_per_inst\": %.2f, \"peak_rss_kb\": %ld }\n",
+		name, (unsigned long long)steps, s, steps / s * 1e-6,
+		steps ? s * 1e9 / steps : 0, ru.ru_maxrss);
+	fflush(out);
+}
+
+
+/**
+ * Command entry point.
+ */
+int main(int argc, char **argv) {
+	arm_platform_t *pf;
+	arm_loader_t *loader;
+	arm_state_t *state;
+	arm_sim_t *sim;
+	arm_address_t exit_addr = 0;
+	int opt, i, cnt;
+
+	/* parse arguments */
+	out = stderr;
+	while((opt = getopt(argc, argv, "o:h")) != -1)
+		switch(opt) {
+		case 'o':
+			out = fopen(optarg, "w");
+			if(out == NULL) {
+				fprintf(stderr, "ERROR: cannot create %s\n", optarg);
+				return 2;
+			}
+			break;
+		default:	usage(); return 1;
+		}
+	if(optind + 2 != argc) {
+		usage();
+		return 1;
+	}
+	name = argv[optind];
+
+	/* load the executable */
+	pf = arm_new_platform();
+	if(pf == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	loader = arm_loader_open(argv[optind + 1]);
+	if(loader == NULL) {
+		fprintf(stderr, "ERROR: cannot load the executable \"%s\"\n", argv[optind + 1]);
+		return 2;
+	}
+	arm_load(pf, loader);
+	cnt = arm_loader_count_syms(loader);
+	for(i = 0; i < cnt; i++) {
+		arm_loader_sym_t sym;
+		arm_loader_sym(loader, i, &sym);
+		if(strcmp(sym.name, "_exit") == 0)
+			exit_addr = sym.value;
+	}
+	arm_loader_close(loader);
+#	ifdef ARM_FUSE
+		if(exit_addr == 0) {
+			fprintf(stderr, "ERROR: no _exit in %s, the fused instructions cannot be counted\n", argv[optind + 1]);
+			return 2;
+		}
+#	endif
+
+	/* build the simulator */
+	state = arm_new_state(pf);
+	if(state == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	sim = arm_new_sim(state, 0, exit_addr);
+	if(sim == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+
+	/* run it */
+	atexit(report);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	while(!arm_is_sim_ended(sim)) {
+		arm_step(sim);
+		steps++;
+	}
+#	ifdef ARM_FUSE
+		for(i = 0; i < ARM_FUSE_KINDS; i++)
+			steps += arm_fuse_hits(state, i);
+#	endif
+	return state->GPR[0];
+}
@@ -0,0 +1,77 @@
+/*
+ * Call-heavy workload of the benchmark suite: recursive functions (PUSH/POP
+ * of many registers), calls through function pointers and structure copies
+ * (LDM/STM). Recursive results are checked against iterative versions.
+ */
+
+#include <stdint.h>
+
+#define ROUNDS	30
+#define FIB		20
+#define COPIES	4096
+
+typedef struct rec_t {
+	uint32_t w[8];
+} rec_t;
+
+static rec_t recs[64];
+
+__attribute__((noinline)) static uint32_t fib(uint32_t n) {
+	return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+__attribute__((noinline)) static uint32_t tak(uint32_t x, uint32_t y, uint32_t z) {
+	return y < x ? tak(tak(x - 1, y, z), tak(y - 1, z, x), tak(z - 1, x, y)) : z;
+}
+
+__attribute__((noinline)) static rec_t mix(rec_t a, rec_t b) {
+	int i;
+	for(i = 0; i < 8; i++)
+		a.w[i] = (a.w[i] ^ b.w[i]) + i;
+	return a;
+}
+
+static uint32_t add(uint32_t a, uint32_t b) { return a + b; }
+static uint32_t sub(uint32_t a, uint32_t b) { return a - b; }
+static uint32_t xor(uint32_t a, uint32_t b) { return a ^ b; }
+static uint32_t (*ops[4])(uint32_t, uint32_t) = { add, sub, xor, add };
+
+int main(void) {
+	uint32_t x = 5, a, b, t, s, u;
+	int r, i, j;
+
+	for(r = 0; r < ROUNDS; r++) {
+		for(i = 0, a = 0, b = 1; i < FIB; i++) {
+			t = a + b; a = b; b = t;
+		}
+		if(fib(FIB) != a)
+			return 1;
+		if(tak(18, 12, 6) != 7)
+			return 2;
+
+		for(i = 0; i < 64; i++)
+			for(j = 0; j < 8; j++) {
+				x = x * 1103515245 + 12345;
+				recs[i].w[j] = x;
+			}
+		for(i = 0, s = 0, u = 0; i < COPIES; i++) {
+			rec_t *p = &recs[i & 63], *q = &recs[(i * 7 + 1) & 63];
+			for(j = 0, t = 0; j < 8; j++)
+				t += ((p->w[j] ^ q->w[j]) + j);
+			*p = mix(*p, *q);
+			for(j = 0; j < 8; j++)
+				s += p->w[j];
+			u += t;
+		}
+		if(s != u)
+			return 3;
+
+		for(i = 0, s = 0, t = 0; i < COPIES; i++) {
+			s = ops[i & 3](s, i);
+			t = (i & 3) == 1 ? t - i : (i & 3) == 2 ? t ^ i : t + i;
+		}
+		if(s != t)
+			return 4;
+	}
+	return 0;
+}
@@ -0,0 +1,663 @@
+/*
+ * ARMv7T -- packed decoding tree builder
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs an executable as training trace and builds, for each instruction set
+ * it executes, a multi-level decoding table of the executed opcodes packed in
+ * 8-byte entries (16 bytes with -e 16: the leaves then check the remaining
+ * fixed bits and let the unknown opcodes go to the generated decoder).
+ *
+ * The decoding bits of an instruction are learnt from the generated decoder:
+ * each bit of an executed opcode is flipped and the bit is a decoding one if
+ * arm_decode() gives another identifier. A node decodes a field of at most
+ * WIDTH bits (-w) taken from the bits decoding all its opcodes. The nodes are
+ * laid out by decreasing execution frequency so that the hot decodings only
+ * touch the head of the table.
+ *
+ * Outputs, by instruction set, a JSON object with the number of executed
+ * instructions, of distinct opcodes, the nodes and size of the table, the
+ * size of its head making 99% of the decodings, the average and maximum
+ * number of nodes visited by a decoding (weighted by the executions) and the
+ * number of executed opcodes the table does not decode as arm_decode(); with
+ * -o, the tables are also written as C. Run by "make decode-footprint" in
+ * test/.
+ *
+ * Thumb opcodes are handled as 32-bit words with the first half-word in the
+ * upper half (16-bit instructions have the lower half null). With ARM_FUSE,
+ * the second instruction of a fused pair is not part of the trace.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arm/api.h>
+#include <arm/loader.h>
+
+#define THUMB_BIT	(1 << 5)
+#define SCRATCH		0x90000000
+#define ISET_CNT	2
+
+static const char *iset_names[ISET_CNT] = { "ARM", "THUMB" };
+
+/* executed opcode */
+typedef struct sample_t {
+	uint32_t op;
+	int iset;
+	uint64_t cnt;
+	int ident;
+	uint32_t mask;
+} sample_t;
+
+/* opcodes with the same identifier and value on its decoding bits */
+typedef struct pattern_t {
+	uint32_t mask, value;
+	int ident;
+	uint64_t weight;
+} pattern_t;
+
+/* node of the tree before packing */
+typedef struct node_t {
+	int shift, bits;
+	int *child;			/* node index or -1 - leaf index */
+	uint64_t weight;
+	uint32_t offset;	/* first entry in the packed table */
+} node_t;
+
+/* leaf of the tree before packing */
+typedef struct leaf_t {
+	int ident;
+	uint32_t mask, value;
+} leaf_t;
+
+/* packed table entry: index is the first entry of the next node
+ * (bits != 0) or the identifier (bits == 0); mask and value are only
+ * stored with 16-byte entries */
+typedef struct entry_t {
+	uint32_t index;
+	uint8_t shift;
+	uint8_t bits;
+	uint16_t pad;
+	uint32_t mask, value;
+} entry_t;
+
+static sample_t *samples = NULL;
+static int sample_cnt = 0, sample_max = 0;
+static int *sample_tab = NULL;
+static int sample_tab_size = 0;
+
+static pattern_t *pats;
+static int pat_cnt;
+static node_t *nodes;
+static int node_cnt, node_max;
+static leaf_t *leaves;
+static int leaf_cnt, leaf_max;
+static entry_t *table;
+static uint32_t entry_cnt;
+
+static int width = 4, entry_size = 8;
+
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: decode-tree [-e 8|16] [-o FILE] [-w WIDTH] NAME EXECUTABLE\n"
+		"\t-e SIZE\tentry size in bytes (default 8, 16 to check the leaves)\n"
+		"\t-o FILE\twrite the tables as C to FILE\n"
+		"\t-w WIDTH\tmaximum bits decoded by a node (default 4)\n");
+}
+
+
+/**
+ * Allocate memory or exit.
+ * @param p		Block to resize (NULL to allocate).
+ * @param size	Size in bytes.
+ * @return		Allocated block.
+ */
+static void *grow(void *p, size_t size) {
+	p = realloc(p, size);
+	if(p == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		exit(2);
+	}
+	return p;
+}
+
+
+/**
+ * Find the sample of an opcode.
+ * @param iset	Instruction set.
+ * @param op	Opcode.
+ * @return		Slot in the hash table (-1 if free).
+ */
+static int *find(int iset, uint32_t op) {
+	int i;
+	for(i = ((op ^ iset) * 0x9e3779b1) >> 7 & (sample_tab_size - 1);
+	sample_tab[i] >= 0 && (samples[sample_tab[i]].op != op || samples[sample_tab[i]].iset != iset);
+	i = (i + 1) & (sample_tab_size - 1))
+		;
+	return &sample_tab[i];
+}
+
+
+/**
+ * Record the execution of an opcode.
+ * @param iset	Instruction set.
+ * @param op	Opcode.
+ */
+static void record(int iset, uint32_t op) {
+	int *s, i;
+
+	if(2 * sample_cnt >= sample_tab_size) {
+		sample_tab_size = sample_tab_size ? 2 * sample_tab_size : 4096;
+		sample_tab = grow(sample_tab, sample_tab_size * sizeof(int));
+		memset(sample_tab, -1, sample_tab_size * sizeof(int));
+		for(i = 0; i < sample_cnt; i++)
+			*find(samples[i].iset, samples[i].op) = i;
+	}
+	s = find(iset, op);
+	if(*s < 0) {
+		if(sample_cnt == sample_max) {
+			sample_max = sample_max ? 2 * sample_max : 4096;
+			samples = grow(samples, sample_max * sizeof(sample_t));
+		}
+		samples[sample_cnt].op = op;
+		samples[sample_cnt].iset = iset;
+		samples[sample_cnt].cnt = 0;
+		*s = sample_cnt++;
+	}
+	samples[*s].cnt++;
+}
+
+
+/**
+ * Read the opcode of the instruction at the given address.
+ * @param mem	Memory.
+ * @param iset	Instruction set.
+ * @param a		Address.
+ * @return		Opcode.
+ */
+static uint32_t fetch(arm_memory_t *mem, int iset, arm_address_t a) {
+	uint32_t h;
+	if(iset == 0)
+		return arm_mem_read32(mem, a);
+	h = arm_mem_read16(mem, a);
+	if((h >> 11) >= 0x1d)
+		return (h << 16) | arm_mem_read16(mem, a + 2);
+	else
+		return h << 16;
+}
+
+
+/**
+ * Decode an opcode with the generated decoder.
+ * @param d		Decoder.
+ * @param s		State giving the instruction set to the decoder.
+ * @param mem	Memory.
+ * @param iset	Instruction set.
+ * @param op	Opcode.
+ * @return		Identifier.
+ */
+static int oracle(arm_decoder_t *d, arm_state_t *s, arm_memory_t *mem, int iset, uint32_t op) {
+	static arm_address_t a = SCRATCH;
+	arm_inst_t *inst;
+	int id;
+
+	/* a new address at each decoding: nothing is reused from a previous one */
+	if(iset == 0)
+		arm_mem_write32(mem, a, op);
+	else {
+		arm_mem_write16(mem, a, op >> 16);
+		arm_mem_write16(mem, a + 2, op);
+	}
+	if(iset == 0)
+		s->APSR &= ~THUMB_BIT;
+	else
+		s->APSR |= THUMB_BIT;
+	arm_set_cond_state(d, s);
+	inst = arm_decode(d, a);
+	id = inst->ident;
+	arm_free_inst(inst);
+	a += 4;
+	return id;
+}
+
+
+/**
+ * Build a node (or a leaf) for the given patterns.
+ * @param ps		Indexes of the patterns.
+ * @param n			Number of patterns.
+ * @param decided	Bits already decoded by the parent nodes.
+ * @return			Node index or -1 - leaf index.
+ */
+static int build(int *ps, int n, uint32_t decided) {
+	uint32_t inter = 0xffffffff, uni = 0, cand, fmask, diff = 0;
+	uint64_t w = 0;
+	int i, j, k, v, shift, bits, pick = -1, same = 1, *sub, num;
+
+	/* leaf? */
+	for(i = 0; i < n; i++) {
+		pattern_t *p = &pats[ps[i]];
+		inter &= p->mask;
+		uni |= p->mask;
+		w += p->weight;
+		diff |= p->value ^ pats[ps[0]].value;
+		if(p->ident != pats[ps[0]].ident)
+			same = 0;
+		if(pick < 0
+		|| __builtin_popcount(p->mask) > __builtin_popcount(pats[pick].mask)
+		|| (__builtin_popcount(p->mask) == __builtin_popcount(pats[pick].mask) && p->weight > pats[pick].weight))
+			pick = ps[i];
+	}
+	cand = inter & ~decided;
+	if(cand == 0)
+		cand = uni & ~decided;
+	if(n == 0 || same || cand == 0) {
+		if(leaf_cnt == leaf_max) {
+			leaf_max = leaf_max ? 2 * leaf_max : 256;
+			leaves = grow(leaves, leaf_max * sizeof(leaf_t));
+		}
+		if(n == 0) {
+			leaves[leaf_cnt].ident = 0;
+			leaves[leaf_cnt].mask = 0;
+			leaves[leaf_cnt].value = 0;
+		}
+		else if(same) {
+			leaves[leaf_cnt].ident = pats[ps[0]].ident;
+			leaves[leaf_cnt].mask = inter & ~diff;
+			leaves[leaf_cnt].value = pats[ps[0]].value & ~diff & inter;
+		}
+
+		/* undistinguishable patterns: the one with the most decoding bits
+		 * wins as its opcodes also match the others */
+		else {
+			leaves[leaf_cnt].ident = pats[pick].ident;
+			leaves[leaf_cnt].mask = pats[pick].mask;
+			leaves[leaf_cnt].value = pats[pick].value;
+		}
+		return -1 - leaf_cnt++;
+	}
+
+	/* select the field: longest run of candidate bits, cut to width */
+	shift = 0;
+	bits = 0;
+	for(i = 0; i < 32; i = j) {
+		for(; i < 32 && !(cand & (1u << i)); i++)
+			;
+		for(j = i; j < 32 && (cand & (1u << j)); j++)
+			;
+		if(j - i >= bits) {
+			shift = i;
+			bits = j - i;
+		}
+	}
+	if(bits > width) {
+		shift += bits - width;
+		bits = width;
+	}
+	fmask = ((1u << bits) - 1) << shift;
+
+	/* allocate the node */
+	if(node_cnt == node_max) {
+		node_max = node_max ? 2 * node_max : 256;
+		nodes = grow(nodes, node_max * sizeof(node_t));
+	}
+	num = node_cnt++;
+	nodes[num].shift = shift;
+	nodes[num].bits = bits;
+	nodes[num].weight = w;
+	nodes[num].child = grow(NULL, (1 << bits) * sizeof(int));
+
+	/* build the children: a pattern not decoding a bit goes in both sides */
+	sub = grow(NULL, n * sizeof(int));
+	for(v = 0; v < (1 << bits); v++) {
+		uint32_t fv = (uint32_t)v << shift;
+		for(i = 0, k = 0; i < n; i++) {
+			pattern_t *p = &pats[ps[i]];
+			if(((p->value ^ fv) & p->mask & fmask) == 0)
+				sub[k++] = ps[i];
+		}
+		k = build(sub, k, decided | fmask);
+		nodes[num].child[v] = k;
+	}
+	free(sub);
+	return num;
+}
+
+
+/**
+ * Compare nodes by decreasing weight.
+ */
+static int by_weight(const void *p1, const void *p2) {
+	const node_t *n1 = *(const node_t **)p1, *n2 = *(const node_t **)p2;
+	if(n1->weight != n2->weight)
+		return n1->weight < n2->weight ? 1 : -1;
+	return n1 < n2 ? -1 : 1;
+}
+
+
+/**
+ * Make the entry of a child.
+ * @param e		Entry to fill.
+ * @param c		Child (node index or -1 - leaf index).
+ */
+static void make_entry(entry_t *e, int c) {
+	memset(e, 0, sizeof(entry_t));
+	if(c >= 0) {
+		e->index = nodes[c].offset;
+		e->shift = nodes[c].shift;
+		e->bits = nodes[c].bits;
+	}
+	else {
+		e->index = leaves[-1 - c].ident;
+		e->mask = leaves[-1 - c].mask;
+		e->value = leaves[-1 - c].value;
+	}
+}
+
+
+/**
+ * Pack the tree, hottest nodes first; entry 0 leads to the root.
+ * @param root	Root (node index or -1 - leaf index).
+ */
+static void pack(int root) {
+	node_t **order;
+	int i, v;
+
+	order = grow(NULL, (node_cnt + 1) * sizeof(node_t *));
+	for(i = 0; i < node_cnt; i++)
+		order[i] = &nodes[i];
+	qsort(order, node_cnt, sizeof(node_t *), by_weight);
+	entry_cnt = 1;
+	for(i = 0; i < node_cnt; i++) {
+		order[i]->offset = entry_cnt;
+		entry_cnt += 1 << order[i]->bits;
+	}
+	free(order);
+
+	table = grow(NULL, entry_cnt * sizeof(entry_t));
+	make_entry(&table[0], root);
+	for(i = 0; i < node_cnt; i++)
+		for(v = 0; v < (1 << nodes[i].bits); v++)
+			make_entry(&table[nodes[i].offset + v], nodes[i].child[v]);
+}
+
+
+/**
+ * Decode an opcode with the packed table.
+ * @param op	Opcode.
+ * @param visit	Set to the number of visited nodes.
+ * @param end	Set to the end (in entries) of the visited part of the table.
+ * @return		Identifier (0 if unknown).
+ */
+static int walk(uint32_t op, int *visit, uint32_t *end) {
+	const entry_t *e = &table[0];
+	*visit = 0;
+	*end = 1;
+	while(e->bits != 0) {
+		if(e->index + (1 << e->bits) > *end)
+			*end = e->index + (1 << e->bits);
+		e = &table[e->index + ((op >> e->shift) & ((1 << e->bits) - 1))];
+		(*visit)++;
+	}
+	if(entry_size == 16 && (op & e->mask) != e->value)
+		return 0;
+	return e->index;
+}
+
+
+/**
+ * Compare (end, count) pairs by increasing end.
+ */
+static int by_end(const void *p1, const void *p2) {
+	const uint64_t *e1 = p1, *e2 = p2;
+	return e1[0] < e2[0] ? -1 : e1[0] > e2[0] ? 1 : 0;
+}
+
+
+/**
+ * Output the packed table as C.
+ * @param out	Output stream.
+ * @param iset	Instruction set.
+ */
+static void output_c(FILE *out, int iset) {
+	uint32_t i;
+	fprintf(out, "const arm_dtree%d_t arm_dtree_%s[%u] = {\n",
+		entry_size, iset == 0 ? "arm" : "thumb", entry_cnt);
+	for(i = 0; i < entry_cnt; i++) {
+		fprintf(out, "\t{ %u, %u, %u, 0", table[i].index, table[i].shift, table[i].bits);
+		if(entry_size == 16)
+			fprintf(out, ", 0x%08x, 0x%08x", table[i].mask, table[i].value);
+		fprintf(out, " },\n");
+	}
+	fprintf(out, "};\n\n");
+}
+
+
+/**
+ * Build, check and report the table of an instruction set.
+ * @param name	Name of the run.
+ * @param iset	Instruction set.
+ * @param out	Output of the C table (NULL for none).
+ */
+static void process(const char *name, int iset, FILE *out) {
+	uint64_t n = 0, vn = 0, acc;
+	uint64_t (*ends)[2];
+	int i, j, k, *ps, root, visit, max_visit = 0, opc = 0, bad = 0, hot = 0;
+	uint32_t end;
+
+	/* merge the samples into patterns */
+	pats = grow(NULL, sample_cnt * sizeof(pattern_t));
+	pat_cnt = 0;
+	for(i = 0; i < sample_cnt; i++) {
+		sample_t *s = &samples[i];
+		uint32_t m = 0;
+		if(s->iset != iset || s->ident == 0)
+			continue;
+		for(j = 0; j < sample_cnt; j++)
+			if(samples[j].iset == iset && samples[j].ident == s->ident)
+				m |= samples[j].mask;
+		for(k = 0; k < pat_cnt; k++)
+			if(pats[k].ident == s->ident && pats[k].value == (s->op & m))
+				break;
+		if(k == pat_cnt) {
+			pats[k].ident = s->ident;
+			pats[k].mask = m;
+			pats[k].value = s->op & m;
+			pats[k].weight = 0;
+			pat_cnt++;
+		}
+		pats[k].weight += s->cnt;
+	}
+	if(pat_cnt == 0) {
+		free(pats);
+		return;
+	}
+
+	/* build and pack */
+	node_cnt = 0;
+	leaf_cnt = 0;
+	ps = grow(NULL, pat_cnt * sizeof(int));
+	for(i = 0; i < pat_cnt; i++)
+		ps[i] = i;
+	root = build(ps, pat_cnt, 0);
+	free(ps);
+	pack(root);
+
+	/* decode the trace with the table */
+	ends = grow(NULL, sample_cnt * sizeof(*ends));
+	for(i = 0; i < sample_cnt; i++) {
+		sample_t *s = &samples[i];
+		if(s->iset != iset || s->ident == 0)
+			continue;
+		if(walk(s->op, &visit, &end) != s->ident)
+			bad++;
+		n += s->cnt;
+		vn += s->cnt * visit;
+		if(visit > max_visit)
+			max_visit = visit;
+		ends[opc][0] = end;
+		ends[opc][1] = s->cnt;
+		opc++;
+	}
+
+	/* head of the table making 99% of the decodings */
+	qsort(ends, opc, sizeof(*ends), by_end);
+	for(i = 0, acc = 0; i < opc; i++) {
+		acc += ends[i][1];
+		if(acc >= n * 99 / 100) {
+			hot = ends[i][0];
+			break;
+		}
+	}
+	free(ends);
+
+	printf("{ \"name\": \"%s\", \"iset\": \"%s\", \"instructions\": %llu, \"opcodes\": %d, "
+		"\"nodes\": %d, \"entry_bytes\": %d, \"bytes\": %u, \"hot_bytes_99\": %u, "
+		"\"avg_nodes\": %.2f, \"max_nodes\": %d, \"mismatches\": %d }\n",
+		name, iset_names[iset], (unsigned long long)n, opc,
+		node_cnt, entry_size, entry_cnt * entry_size, hot * entry_size,
+		n ? (double)vn / n : 0, max_visit, bad);
+	if(out != NULL)
+		output_c(out, iset);
+
+	for(i = 0; i < node_cnt; i++)
+		free(nodes[i].child);
+	free(table);
+	free(pats);
+}
+
+
+/**
+ * Command entry point.
+ */
+int main(int argc, char **argv) {
+	arm_platform_t *pf;
+	arm_loader_t *loader;
+	arm_state_t *state, *ps;
+	arm_decoder_t *d;
+	arm_memory_t *mem;
+	arm_sim_t *sim;
+	arm_address_t exit_addr = 0;
+	FILE *out = NULL;
+	int opt, i, b, cnt, iset, bits;
+
+	/* parse arguments */
+	while((opt = getopt(argc, argv, "e:o:w:h")) != -1)
+		switch(opt) {
+		case 'e':
+			entry_size = atoi(optarg);
+			if(entry_size != 8 && entry_size != 16) {
+				usage();
+				return 1;
+			}
+			break;
+		case 'o':
+			out = fopen(optarg, "w");
+			if(out == NULL) {
+				fprintf(stderr, "ERROR: cannot create %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'w':
+			width = atoi(optarg);
+			if(width < 1 || width > 16) {
+				usage();
+				return 1;
+			}
+			break;
+		default:	usage(); return 1;
+		}
+	if(optind + 2 != argc) {
+		usage();
+		return 1;
+	}
+
+	/* load the executable */
+	pf = arm_new_platform();
+	if(pf == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	loader = arm_loader_open(argv[optind + 1]);
+	if(loader == NULL) {
+		fprintf(stderr, "ERROR: cannot load the executable \"%s\"\n", argv[optind + 1]);
+		return 2;
+	}
+	arm_load(pf, loader);
+	cnt = arm_loader_count_syms(loader);
+	for(i = 0; i < cnt; i++) {
+		arm_loader_sym_t sym;
+		arm_loader_sym(loader, i, &sym);
+		if(strcmp(sym.name, "_exit") == 0)
+			exit_addr = sym.value;
+	}
+	arm_loader_close(loader);
+	mem = arm_get_memory(pf, ARM_MAIN_MEMORY);
+
+	/* run the training trace */
+	state = arm_new_state(pf);
+	ps = arm_new_state(pf);
+	d = arm_new_decoder(pf);
+	if(state == NULL || ps == NULL || d == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	sim = arm_new_sim(state, 0, exit_addr);
+	if(sim == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	while(!arm_is_sim_ended(sim)) {
+		iset = (state->APSR & THUMB_BIT) != 0;
+		record(iset, fetch(mem, iset, state->GPR[15]));
+		arm_step(sim);
+	}
+
+	/* learn the decoding bits */
+	for(i = 0; i < sample_cnt; i++) {
+		sample_t *s = &samples[i];
+		s->ident = oracle(d, ps, mem, s->iset, s->op);
+		s->mask = 0;
+		if(s->ident == 0)
+			continue;
+		bits = s->iset == 0 || (s->op >> 27) >= 0x1d ? 0 : 16;
+		for(b = bits; b < 32; b++)
+			if(oracle(d, ps, mem, s->iset, s->op ^ (1u << b)) != s->ident)
+				s->mask |= 1u << b;
+	}
+
+	/* build the tables */
+	if(out != NULL)
+		fprintf(out, "/* generated by decode-tree from %s */\n\n"
+			"typedef struct { uint32_t index; uint8_t shift, bits; uint16_t pad; } arm_dtree8_t;\n"
+			"typedef struct { uint32_t index; uint8_t shift, bits; uint16_t pad; uint32_t mask, value; } arm_dtree16_t;\n\n",
+			argv[optind + 1]);
+	for(iset = 0; iset < ISET_CNT; iset++)
+		process(argv[optind], iset, out);
+	if(out != NULL)
+		fclose(out);
+
+	arm_delete_sim(sim);
+	arm_delete_decoder(d);
+	arm_delete_state(ps);
+	arm_unlock_platform(pf);
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * ARMv7T -- decoding and disassembly micro-benchmark
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Decodes (and disassembles with -d) the text sections of an executable
+ * ROUNDS times, as ARM or as Thumb (-t), and outputs a JSON
+ * object with the number of instructions, the time, the millions of
+ * instructions per second, the time per instruction and the peak resident
+ * set size of the process. With -s, the instructions are decoded with the
+ * table of the instruction set of the state (see extern/iset.h) instead of
+ * arm_decode() that selects it at each decoding. Also run by
+ * "make decode-bench" in test/ to compare the ARM and the Thumb decoding
+ * tables, with and without the selection.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <arm/api.h>
+#include <arm/loader.h>
+
+#define ROUNDS	100
+
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: dis-bench [-d] [-s] [-t] NAME EXECUTABLE\n"
+		"\t-d\tdisassemble the decoded instructions\n"
+		"\t-s\tdecode with the table of the state (no selection)\n"
+		"\t-t\tdecode as Thumb (default ARM)\n");
+}
+
+
+/**
+ * Command entry point.
+ */
+int main(int argc, char **argv) {
+	arm_platform_t *pf;
+	arm_loader_t *loader;
+	arm_decoder_t *d;
+	arm_state_t *state;
+	struct timespec t0, t1;
+	struct rusage ru;
+	unsigned long long n = 0;
+	arm_inst_t *(*decode)(arm_decoder_t *decoder, arm_address_t address) = arm_decode;
+	int opt, dis = 0, thumb = 0, i, r, cnt;
+	char buf[100];
+	double s;
+
+	/* parse arguments */
+	while((opt = getopt(argc, argv, "dsth")) != -1)
+		switch(opt) {
+		case 'd':	dis = 1; break;
+		case 's':
+			if(arm_modes[0].name == NULL) {
+				fprintf(stderr, "ERROR: no decoding table by instruction set in this build\n");
+				return 1;
+			}
+			decode = NULL;
+			break;
+		case 't':	thumb = 1; break;
+		default:	usage(); return 1;
+		}
+	if(optind + 2 != argc) {
+		usage();
+		return 1;
+	}
+
+	/* load the executable */
+	loader = arm_loader_open(argv[optind + 1]);
+	if(loader == NULL) {
+		fprintf(stderr, "ERROR: cannot load the executable \"%s\"\n", argv[optind + 1]);
+		return 2;
+	}
+	pf = arm_new_platform();
+	if(pf == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	arm_loader_load(loader, pf);
+	state = arm_new_state(pf);
+	d = arm_new_decoder(pf);
+	if(state == NULL || d == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	if(thumb)
+		state->APSR |= 1 << 5;
+	else
+		state->APSR &= ~(1 << 5);
+	arm_set_cond_state(d, state);
+	arm_iset_update(state);
+	if(decode == NULL)
+		decode = arm_modes[state->iset].decode;
+
+	/* decode the text sections */
+	cnt = arm_loader_count_sects(loader);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(r = 0; r < ROUNDS; r++)
+		for(i = 0; i < cnt; i++) {
+			arm_loader_sect_t sect;
+			arm_address_t a;
+			arm_loader_sect(loader, i, &sect);
+			if(sect.type != ARM_LOADER_SECT_TEXT)
+				continue;
+			for(a = sect.addr; a < sect.addr + sect.size; n++) {
+				arm_inst_t *inst = decode(d, a);
+				if(dis)
+					arm_disasm(buf, inst);
+				a += arm_get_inst_size(inst) / 8;
+				arm_free_inst(inst);
+			}
+		}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	getrusage(RUSAGE_SELF, &ru);
+
+	s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+	printf("{ \"name\": \"%s\", \"instructions\": %llu, \"seconds\": %.3f, "
+		"\"mips\": %.2f, \"ns_per_inst\": %.2f, \"peak_rss_kb\": %ld }\n",
+		argv[optind], n, s, n / s * 1e-6, n ? s * 1e9 / n : 0, ru.ru_maxrss);
+
+	arm_delete_decoder(d);
+	arm_delete_state(state);
+	arm_loader_close(loader);
+	arm_unlock_platform(pf);
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * DSP workload of the benchmark suite: Q15 FIR filter with dual 16-bit
+ * multiply-accumulate, saturating mix of two signals and saturating packed
+ * additions. The DSP instructions (ACLE intrinsics) are checked against
+ * a plain C reference.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#ifdef __ARM_FEATURE_DSP
+#include <arm_acle.h>
+#endif
+
+#define ROUNDS	12
+#define SIZE	2048
+#define TAPS	16
+
+static int16_t in[SIZE + TAPS], in2[SIZE], coef[TAPS];
+static int16_t out[SIZE], ref[SIZE];
+
+static inline int32_t clamp(int64_t v, int bits) {
+	int64_t m = ((int64_t)1 << (bits - 1)) - 1;
+	return v > m ? m : v < -m - 1 ? -m - 1 : v;
+}
+
+static inline uint32_t pair(const int16_t *p) {
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static void fir(void) {
+	int i, j;
+	for(i = 0; i < SIZE; i++) {
+		int32_t acc = 0;
+		for(j = 0; j < TAPS; j += 2)
+#ifdef __ARM_FEATURE_DSP
+			acc = __smlad(pair(&in[i + j]), pair(&coef[j]), acc);
+		out[i] = __ssat(acc >> 15, 16);
+#else
+			acc += in[i + j] * coef[j] + in[i + j + 1] * coef[j + 1];
+		out[i] = clamp(acc >> 15, 16);
+#endif
+	}
+}
+
+static void fir_ref(void) {
+	int i, j;
+	for(i = 0; i < SIZE; i++) {
+		int64_t acc = 0;
+		for(j = 0; j < TAPS; j++)
+			acc += (int64_t)in[i + j] * coef[j];
+		ref[i] = clamp(acc >> 15, 16);
+	}
+}
+
+static void mix(void) {
+	int i;
+	for(i = 0; i < SIZE; i++)
+#ifdef __ARM_FEATURE_DSP
+		out[i] = __qadd(in[i] * 65536, in2[i] * 65536) >> 16;
+#else
+		out[i] = clamp((int64_t)in[i] + in2[i], 16);
+#endif
+}
+
+static void add16(void) {
+	int i;
+	for(i = 0; i < SIZE; i += 2) {
+#ifdef __ARM_FEATURE_DSP
+		uint32_t v = __qadd16(pair(&in[i]), pair(&in2[i]));
+		memcpy(&out[i], &v, 4);
+#else
+		out[i] = clamp((int64_t)in[i] + in2[i], 16);
+		out[i + 1] = clamp((int64_t)in[i + 1] + in2[i + 1], 16);
+#endif
+	}
+}
+
+static int check_sum(void) {
+	int i;
+	for(i = 0; i < SIZE; i++)
+		if(out[i] != clamp((int64_t)in[i] + in2[i], 16))
+			return 0;
+	return 1;
+}
+
+int main(void) {
+	uint32_t x = 7;
+	int r, i;
+
+	for(r = 0; r < ROUNDS; r++) {
+		for(i = 0; i < SIZE + TAPS; i++) {
+			x = x * 1103515245 + 12345;
+			in[i] = x >> 16;
+		}
+		for(i = 0; i < SIZE; i++) {
+			x = x * 1103515245 + 12345;
+			in2[i] = x >> 16;
+		}
+		for(i = 0; i < TAPS; i++) {
+			x = x * 1103515245 + 12345;
+			coef[i] = (int16_t)(x >> 16) >> 5;
+		}
+
+		fir();
+		fir_ref();
+		if(memcmp(out, ref, sizeof(out)) != 0)
+			return 1;
+		mix();
+		if(!check_sum())
+			return 2;
+		add16();
+		if(!check_sum())
+			return 3;
+	}
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Floating-point workload of the benchmark suite (single precision, VFP):
+ * linear system solved by Gaussian elimination and checked by its
+ * residual, Newton square roots checked against VSQRT and a polynomial
+ * evaluated by Horner against the expanded form.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+#define ROUNDS	30
+#define N		24
+#define SIZE	1024
+
+static float a[N][N + 1], m[N][N + 1], xs[N];
+static float vals[SIZE];
+
+static float frand(uint32_t *x) {
+	*x = *x * 1103515245 + 12345;
+	return (float)(*x >> 8) / (float)(1 << 24) - .5f;
+}
+
+static void solve(void) {
+	int i, j, k, p;
+	for(i = 0; i < N; i++)
+		for(j = 0; j <= N; j++)
+			m[i][j] = a[i][j];
+	for(k = 0; k < N; k++) {
+		for(p = k, i = k + 1; i < N; i++)
+			if(fabsf(m[i][k]) > fabsf(m[p][k]))
+				p = i;
+		for(j = k; j <= N; j++) {
+			float t = m[k][j]; m[k][j] = m[p][j]; m[p][j] = t;
+		}
+		for(i = k + 1; i < N; i++) {
+			float f = m[i][k] / m[k][k];
+			for(j = k; j <= N; j++)
+				m[i][j] -= f * m[k][j];
+		}
+	}
+	for(i = N - 1; i >= 0; i--) {
+		float s = m[i][N];
+		for(j = i + 1; j < N; j++)
+			s -= m[i][j] * xs[j];
+		xs[i] = s / m[i][i];
+	}
+}
+
+static int residual(void) {
+	int i, j;
+	for(i = 0; i < N; i++) {
+		float s = -a[i][N];
+		for(j = 0; j < N; j++)
+			s += a[i][j] * xs[j];
+		if(fabsf(s) > 1e-3f)
+			return 0;
+	}
+	return 1;
+}
+
+static float newton(float v) {
+	float r = v > 1 ? v : 1;
+	int i;
+	for(i = 0; i < 20; i++)
+		r = .5f * (r + v / r);
+	return r;
+}
+
+int main(void) {
+	uint32_t x = 3;
+	int r, i, j;
+
+	for(r = 0; r < ROUNDS; r++) {
+		for(i = 0; i < N; i++) {
+			for(j = 0; j <= N; j++)
+				a[i][j] = frand(&x);
+			a[i][i] += N;	/* diagonally dominant */
+		}
+		solve();
+		if(!residual())
+			return 1;
+
+		for(i = 0; i < SIZE; i++) {
+			vals[i] = (frand(&x) + .5f) * 1000.f;
+			if(fabsf(newton(vals[i]) - sqrtf(vals[i])) > 1e-3f * sqrtf(vals[i]))
+				return 2;
+		}
+
+		for(i = 0; i < SIZE; i++) {
+			float t = vals[i] / 1000.f;
+			float h = ((((3.f * t - 2.f) * t + .5f) * t - 1.f) * t + 4.f);
+			float e = 3.f * t * t * t * t - 2.f * t * t * t + .5f * t * t - t + 4.f;
+			if(fabsf(h - e) > 1e-4f)
+				return 3;
+		}
+	}
+	return 0;
+}
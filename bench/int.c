@@ -0,0 +1,143 @@
+/*
+ * Integer workload of the benchmark suite, after CoreMark: linked list
+ * search and sort, 16-bit matrix multiply and a state machine scanning
+ * numbers in a text. Each kernel is checked against a simple reference.
+ */
+
+#include <stdint.h>
+
+#define ROUNDS	40
+#define NODES	256
+#define N		24
+#define TEXT	2048
+
+typedef struct node_t {
+	struct node_t *next;
+	int16_t key;
+	int16_t idx;
+} node_t;
+
+static node_t nodes[NODES];
+static int16_t ma[N][N], mb[N][N];
+static int32_t mc[N][N];
+static char text[TEXT];
+
+static node_t *list_sort(node_t *l) {
+	node_t *p, *q, *e, *tail;
+	int k = 1, merges, ps, qs, i;
+	for(;; k <<= 1) {
+		p = l; l = tail = 0; merges = 0;
+		while(p) {
+			merges++;
+			for(q = p, ps = 0, i = 0; i < k && q; i++, ps++)
+				q = q->next;
+			qs = k;
+			while(ps > 0 || (qs > 0 && q)) {
+				if(ps == 0 || (qs > 0 && q && q->key < p->key))
+					{ e = q; q = q->next; qs--; }
+				else
+					{ e = p; p = p->next; ps--; }
+				if(tail) tail->next = e; else l = e;
+				tail = e;
+			}
+			p = q;
+		}
+		tail->next = 0;
+		if(merges <= 1)
+			return l;
+	}
+}
+
+static int list_check(node_t *l, int n, uint32_t sum) {
+	for(; l; l = l->next, n--) {
+		sum -= l->key;
+		if(l->next && l->next->key < l->key)
+			return 0;
+	}
+	return n == 0 && sum == 0;
+}
+
+static int matrix(int r) {
+	int i, j, k;
+	for(i = 0; i < N; i++)
+		for(j = 0; j < N; j++) {
+			int32_t s = 0;
+			for(k = 0; k < N; k++)
+				s += ma[i][k] * mb[k][j];
+			mc[i][j] = s;
+		}
+	/* reference: one row in the other loop order */
+	i = r % N;
+	for(j = 0; j < N; j++) {
+		int32_t s = 0;
+		for(k = N - 1; k >= 0; k--)
+			s += mb[k][j] * ma[i][k];
+		if(s != mc[i][j])
+			return 0;
+	}
+	return 1;
+}
+
+static int scan(const char *p, uint32_t *sum) {
+	uint32_t v = 0;
+	int state = 0, c = 0;
+	for(;; p++) {
+		if(*p >= '0' && *p <= '9') {
+			v = v * 10 + *p - '0';
+			state = 1;
+		}
+		else {
+			if(state) { *sum += v; c++; }
+			v = 0; state = 0;
+			if(*p == 0)
+				return c;
+		}
+	}
+}
+
+int main(void) {
+	uint32_t x = 1, sum, s, ref;
+	int r, i, cnt, refc;
+	node_t *l;
+
+	for(r = 0; r < ROUNDS; r++) {
+		for(i = 0, l = 0, sum = 0; i < NODES; i++) {
+			x = x * 1103515245 + 12345;
+			nodes[i].key = x >> 20;
+			nodes[i].idx = i;
+			nodes[i].next = l;
+			l = &nodes[i];
+			sum += nodes[i].key;
+		}
+		if(!list_check(list_sort(l), NODES, sum))
+			return 1;
+
+		for(i = 0; i < N * N; i++) {
+			x = x * 1103515245 + 12345;
+			ma[i / N][i % N] = x >> 18;
+			mb[i % N][i / N] = x >> 22;
+		}
+		if(!matrix(r))
+			return 2;
+
+		for(i = 0, refc = 0, ref = 0; i < TEXT - 1; i++) {
+			x = x * 1103515245 + 12345;
+			text[i] = (x >> 28) < 10 ? '0' + (x >> 24) % 10 : ' ';
+		}
+		text[TEXT - 1] = 0;
+		for(i = 0; i < TEXT - 1; i++)
+			if(text[i] != ' ' && (i == 0 || text[i - 1] == ' ')) {
+				uint32_t v = 0;
+				int j;
+				for(j = i; text[j] >= '0' && text[j] <= '9'; j++)
+					v = v * 10 + text[j] - '0';
+				ref += v;
+				refc++;
+			}
+		s = 0;
+		cnt = scan(text, &s);
+		if(cnt != refc || s != ref)
+			return 3;
+	}
+	return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * Memory-bound workload of the benchmark suite: pointer chasing through
+ * a random cycle of 4 MiB, block copies and strided accesses over 1 MiB.
+ * The chase must come back to its start after visiting every element
+ * and the copies are compared.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define ROUNDS	4
+#define CHASE	(1 << 20)
+#define BLOCK	(1 << 20)
+#define STRIDE	64
+
+static uint32_t next[CHASE];
+static uint32_t src[BLOCK / 4], dst[BLOCK / 4];
+
+int main(void) {
+	uint32_t x = 11, i, j, p, n, s, t;
+	int r;
+
+	/* single random cycle (Sattolo) */
+	for(i = 0; i < CHASE; i++)
+		next[i] = i;
+	for(i = CHASE - 1; i > 0; i--) {
+		x = x * 1103515245 + 12345;
+		j = (x >> 8) % i;
+		t = next[i]; next[i] = next[j]; next[j] = t;
+	}
+
+	for(r = 0; r < ROUNDS; r++) {
+		for(p = next[0], n = 1; p != 0; p = next[p])
+			n++;
+		if(n != CHASE)
+			return 1;
+
+		for(i = 0; i < BLOCK / 4; i++)
+			src[i] = i * 2654435761u + r;
+		memcpy(dst, src, BLOCK);
+		if(memcmp(dst, src, BLOCK) != 0)
+			return 2;
+		memset(dst, r, BLOCK);
+
+		for(s = 0, t = 0, j = 0; j < STRIDE / 4; j++)
+			for(i = j; i < BLOCK / 4; i += STRIDE / 4) {
+				s += src[i];
+				t += (i * 2654435761u + r);
+			}
+		if(s != t)
+			return 3;
+	}
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * ARMv7T -- coverage bitmap merger
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arm/cover.h>
+
+/* options */
+const char *out_path = NULL;
+int summary = 0;
+
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: arm-cover-merge [-s] [-o OUTPUT] BITMAP...\n"
+		"\t-o OUTPUT\tmerge the bitmaps in OUTPUT\n"
+		"\t-s\t\tdisplay the coverage by section\n");
+}
+
+
+/**
+ * Load a bitmap file.
+ * @param path	Path of the file.
+ * @param size	Filled with the file size.
+ * @return		File content or NULL (error displayed).
+ */
+uint8_t *load(const char *path, size_t *size) {
+	FILE *in;
+	uint8_t *buf = NULL;
+	long s;
+
+	in = fopen(path, "rb");
+	if(in == NULL || fseek(in, 0, SEEK_END) != 0 || (s = ftell(in)) < ARM_COVER_HEADER) {
+		fprintf(stderr, "ERROR: cannot read %s\n", path);
+		goto done;
+	}
+	rewind(in);
+	buf = (uint8_t *)malloc(s);
+	if(buf == NULL || fread(buf, 1, s, in) != (size_t)s) {
+		fprintf(stderr, "ERROR: cannot read %s\n", path);
+		free(buf);
+		buf = NULL;
+		goto done;
+	}
+	if(memcmp(buf, ARM_COVER_MAGIC, 8) != 0) {
+		fprintf(stderr, "ERROR: %s is not a coverage bitmap\n", path);
+		free(buf);
+		buf = NULL;
+		goto done;
+	}
+	*size = s;
+done:
+	if(in != NULL)
+		fclose(in);
+	return buf;
+}
+
+
+/**
+ * Display the coverage of each section.
+ * @param buf	Bitmap file content.
+ */
+void display(uint8_t *buf) {
+	uint32_t cnt, i, j, n;
+	arm_cover_sect_t *sects = (arm_cover_sect_t *)(buf + ARM_COVER_HEADER);
+
+	memcpy(&cnt, buf + 8, 4);
+	for(i = 0; i < cnt; i++) {
+		uint32_t total = (sects[i].size + 1) / 2;
+		n = 0;
+		for(j = 0; j < total; j++)
+			if(buf[sects[i].offset + j / 8] & (1 << (j % 8)))
+				n++;
+		printf("%08x-%08x: %u / %u halfwords (%.1f%%)\n",
+			sects[i].addr, sects[i].addr + sects[i].size, n, total,
+			total == 0 ? 0. : 100. * n / total);
+	}
+}
+
+
+int main(int argc, char **argv) {
+	uint8_t *res = NULL, *buf;
+	size_t res_size = 0, size, i;
+	int a, cnt = 0;
+	FILE *out;
+
+	/* parse arguments */
+	for(a = 1; a < argc; a++) {
+		if(strcmp(argv[a], "-s") == 0)
+			summary = 1;
+		else if(strcmp(argv[a], "-o") == 0 && a + 1 < argc)
+			out_path = argv[++a];
+		else if(argv[a][0] == '-') {
+			usage();
+			return 1;
+		}
+		else {
+
+			/* merge the bitmap */
+			buf = load(argv[a], &size);
+			if(buf == NULL)
+				return 2;
+			if(res == NULL) {
+				res = buf;
+				res_size = size;
+			}
+			else {
+				uint32_t n;
+				memcpy(&n, buf + 8, 4);
+				if(size != res_size || memcmp(res, buf, ARM_COVER_HEADER + n * sizeof(arm_cover_sect_t)) != 0) {
+					fprintf(stderr, "ERROR: %s does not match the executable of the other bitmaps\n", argv[a]);
+					return 3;
+				}
+				for(i = ARM_COVER_HEADER + n * sizeof(arm_cover_sect_t); i < size; i++)
+					res[i] |= buf[i];
+				free(buf);
+			}
+			cnt++;
+		}
+	}
+	if(cnt == 0 || (out_path == NULL && !summary)) {
+		usage();
+		return 1;
+	}
+
+	/* output the result */
+	if(out_path != NULL) {
+		out = fopen(out_path, "wb");
+		if(out == NULL || fwrite(res, 1, res_size, out) != res_size) {
+			fprintf(stderr, "ERROR: cannot write %s\n", out_path);
+			return 2;
+		}
+		fclose(out);
+	}
+	if(summary)
+		display(res);
+	free(res);
+	return 0;
+}
@@ -0,0 +1,195 @@
+/*!
+ * Basic block vectors for sampled simulation
+ *
+ * \file bbv.c
+ *
+ * Blocks are looked up (in a hash table indexed by start address) only
+ * when the control flow is not sequential; other instructions just
+ * increment the counter of the current block. Blocks executed in the
+ * current interval are linked so that the vector is output and reset
+ * without scanning all blocks.
+ *
+ * Configuration from the environment (read when the state is created):
+ *	- ARM_BBV_OUT -- file to output BBV to (BBV disabled if not set),
+ *	- ARM_BBV_INTERVAL -- interval length in instructions (default DEFAULT_INTERVAL),
+ *	- ARM_FORWARD -- number of instructions to fast-forward.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <gliss/api.h>
+#include <gliss/bbv.h>
+
+#define DEFAULT_INTERVAL	10000000
+#define HASH_SIZE			(1 << 16)
+
+typedef struct block_t {
+	struct block_t *next;		/* in hash table */
+	struct block_t *touched;	/* in current interval */
+	uint32_t addr;
+	uint32_t id;
+	uint64_t cnt;
+} block_t;
+
+typedef struct gliss_bbv_t {
+	FILE *out;
+	uint64_t interval;
+	uint64_t left;				/* instructions left in the interval */
+	uint32_t next;				/* next sequential address */
+	uint32_t last_id;
+	block_t *cur;
+	block_t *touched;
+	block_t *blocks[HASH_SIZE];
+} gliss_bbv_t;
+
+static block_t end_of_list;		/* touched list terminator */
+
+
+/**
+ * Initialize BBV and fast-forward of a state from the environment.
+ * @param state		Initialized state.
+ */
+void gliss_bbv_init(gliss_state_t *state) {
+	const char *path = getenv("ARM_BBV_OUT"), *val;
+	uint64_t interval = DEFAULT_INTERVAL;
+
+	state->bbv = NULL;
+	state->forward = 0;
+	val = getenv("ARM_FORWARD");
+	if(val != NULL)
+		state->forward = strtoull(val, NULL, 0);
+	if(path != NULL) {
+		val = getenv("ARM_BBV_INTERVAL");
+		if(val != NULL)
+			interval = strtoull(val, NULL, 0);
+		if(gliss_bbv_start(state, path, interval) != 0)
+			fprintf(stderr, "ERROR: cannot output BBV to %s\n", path);
+	}
+}
+
+
+/**
+ * Set the number of instructions to execute before enabling
+ * the instruction probes.
+ * @param state		Current state.
+ * @param count		Number of instructions to fast-forward.
+ */
+void gliss_bbv_forward_to(gliss_state_t *state, uint64_t count) {
+	state->forward = count;
+}
+
+
+/**
+ * Start collecting BBV.
+ * @param state		Current state.
+ * @param path		File to output to.
+ * @param interval	Interval length (in instructions).
+ * @return			0 for success, -1 else.
+ */
+int gliss_bbv_start(gliss_state_t *state, const char *path, uint64_t interval) {
+	gliss_bbv_t *bbv;
+
+	if(interval == 0)
+		return -1;
+	gliss_bbv_stop(state);
+	bbv = (gliss_bbv_t *)calloc(1, sizeof(gliss_bbv_t));
+	if(bbv == NULL)
+		return -1;
+	bbv->out = fopen(path, "w");
+	if(bbv->out == NULL) {
+		free(bbv);
+		return -1;
+	}
+	bbv->interval = interval;
+	bbv->left = interval;
+	bbv->next = 0xffffffff;
+	bbv->touched = &end_of_list;
+	state->bbv = bbv;
+	return 0;
+}
+
+
+/**
+ * Output the vector of the current interval and reset it.
+ * @param bbv	Current BBV.
+ */
+static void flush(gliss_bbv_t *bbv) {
+	block_t *b, *n;
+
+	if(bbv->touched == &end_of_list)
+		return;
+	fputc('T', bbv->out);
+	for(b = bbv->touched; b != &end_of_list; b = n) {
+		fprintf(bbv->out, ":%u:%llu ", b->id, (unsigned long long)b->cnt);
+		n = b->touched;
+		b->cnt = 0;
+		b->touched = NULL;
+	}
+	fputc('\n', bbv->out);
+	bbv->touched = &end_of_list;
+}
+
+
+/**
+ * Stop collecting BBV, the last (partial) interval is output.
+ * @param state		Current state.
+ */
+void gliss_bbv_stop(gliss_state_t *state) {
+	gliss_bbv_t *bbv = state->bbv;
+	block_t *b, *n;
+	int i;
+
+	if(bbv == NULL)
+		return;
+	flush(bbv);
+	fclose(bbv->out);
+	for(i = 0; i < HASH_SIZE; i++)
+		for(b = bbv->blocks[i]; b != NULL; b = n) {
+			n = b->next;
+			free(b);
+		}
+	free(bbv);
+	state->bbv = NULL;
+}
+
+
+/**
+ * Record the execution of an instruction.
+ * @param bbv	Current BBV.
+ * @param addr	Instruction address.
+ * @param size	Instruction size (in bytes).
+ */
+void gliss_bbv_record(gliss_bbv_t *bbv, uint32_t addr, int size) {
+	block_t *b;
+
+	/* new block? */
+	if(addr != bbv->next || bbv->cur == NULL) {
+		int h = (addr >> 1) & (HASH_SIZE - 1);
+		for(b = bbv->blocks[h]; b != NULL && b->addr != addr; b = b->next);
+		if(b == NULL) {
+			b = (block_t *)calloc(1, sizeof(block_t));
+			if(b == NULL)
+				return;
+			b->addr = addr;
+			b->id = ++bbv->last_id;
+			b->next = bbv->blocks[h];
+			bbv->blocks[h] = b;
+		}
+		bbv->cur = b;
+	}
+	bbv->next = addr + size;
+
+	/* count the instruction */
+	b = bbv->cur;
+	if(b->touched == NULL) {
+		b->touched = bbv->touched;
+		bbv->touched = b;
+	}
+	b->cnt++;
+
+	/* end of interval? */
+	if(--bbv->left == 0) {
+		flush(bbv);
+		bbv->left = bbv->interval;
+	}
+}
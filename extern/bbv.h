@@ -0,0 +1,50 @@
+/*!
+ * Basic block vectors for sampled simulation
+ *
+ * \file bbv.h
+ *
+ * Only linked when WITH_BBV is configured. The executed instructions are
+ * split in intervals of fixed length and, for each interval, the number of
+ * instructions executed by each basic block is output in the format of
+ * the SimPoint tools (one line "T:id:count :id:count ..." per interval).
+ * Blocks are dynamic basic blocks: sequences of instructions starting at
+ * the target of a control transfer.
+ *
+ * This module also provides the fast-forward: the given number of
+ * instructions is executed with all instruction probes disabled before
+ * the instrumentation (including BBV) starts.
+ */
+
+#ifndef GLISS_BBV_H
+#define GLISS_BBV_H
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+struct gliss_bbv_t;
+
+#define GLISS_BBV_STATE			struct gliss_bbv_t *bbv; uint64_t forward;
+#define GLISS_BBV_INIT(s)		gliss_bbv_init(s)
+#define GLISS_BBV_DESTROY(s)	gliss_bbv_stop(s)
+
+/* probe gate: true while fast-forwarding */
+#define gliss_bbv_forward(s)	((s)->forward != 0 && ((s)->forward--, 1))
+
+/* instruction probe: s is the state, a the address, z the size */
+#define gliss_bbv_inst(s, a, z)	{ if((s)->bbv != 0) gliss_bbv_record((s)->bbv, (a), (z)); }
+
+void gliss_bbv_init(struct gliss_state_t *state);
+int gliss_bbv_start(struct gliss_state_t *state, const char *path, uint64_t interval);
+void gliss_bbv_stop(struct gliss_state_t *state);
+void gliss_bbv_forward_to(struct gliss_state_t *state, uint64_t count);
+void gliss_bbv_record(struct gliss_bbv_t *bbv, uint32_t addr, int size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_BBV_H */
@@ -0,0 +1,537 @@
+/*!
+ * L1 instruction and data cache simulation
+ *
+ * \file cache.c
+ *
+ * The tags of a cache are stored as a structure of arrays: the tags of the
+ * ways of a set are contiguous (line number, INVALID if empty) and separated
+ * from the replacement stamps, so that a set is searched with SSE2 compares
+ * of four tags at once when the number of ways is a multiple of 4. LRU and
+ * FIFO replace the way with the oldest stamp (last use or fill), empty ways
+ * having a null stamp.
+ *
+ * Counters by line and by instruction are kept in hash tables and only
+ * summed up by function or address range when the statistics are dumped.
+ *
+ * If the environment variable ARM_CACHE_OUT is set when the state is
+ * created, the statistics are output in CSV to the named file when the
+ * state is destroyed, using the symbols of the executable given by
+ * ARM_CACHE_EXE and the address ranges given by ARM_CACHE_RANGES
+ * ("low-high,..." in hexadecimal, high excluded).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/mem.h>
+#include <gliss/loader.h>
+#include <gliss/sys_call.h>
+#include <gliss/cache.h>
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+#define INVALID		0xffffffff
+#define HASH_SIZE	(1 << 14)
+#define MAX_RANGES	16
+
+typedef struct site_t {
+	struct site_t *next;
+	uint32_t addr;
+	uint64_t acc, miss;
+} site_t;
+
+typedef struct gliss_cache_t {
+	char config[64];
+	uint32_t ways, set_mask;
+	int line_bits, policy;
+	uint32_t seed;
+	uint64_t clock;
+	uint32_t *tags;				/* sets x ways */
+	uint64_t *stamps;			/* sets x ways */
+	uint64_t acc, miss;
+	site_t *lines[HASH_SIZE];	/* by (first accessed address of) line */
+	site_t *insts[HASH_SIZE];	/* by accessing instruction */
+} gliss_cache_t;
+
+typedef struct func_t {
+	uint32_t addr;
+	uint32_t size;
+	const char *name;
+	uint64_t acc, miss;
+} func_t;
+
+
+/**
+ * Build a cache from its configuration.
+ * @param config	"size:ways:line[:policy]".
+ * @return			Built cache or NULL if the configuration is invalid.
+ */
+static gliss_cache_t *cache_new(const char *config) {
+	unsigned long size, ways, line;
+	char policy[16] = "lru";
+	gliss_cache_t *c;
+	uint32_t sets, i;
+
+	if(sscanf(config, "%lu:%lu:%lu:%15s", &size, &ways, &line, policy) < 3
+	|| ways == 0 || line < 4 || (line & (line - 1)) != 0
+	|| size < ways * line || size % (ways * line) != 0)
+		return NULL;
+	sets = size / (ways * line);
+	if((sets & (sets - 1)) != 0)
+		return NULL;
+
+	c = (gliss_cache_t *)calloc(1, sizeof(gliss_cache_t));
+	if(c == NULL)
+		return NULL;
+	if(strcmp(policy, "lru") == 0)
+		c->policy = GLISS_CACHE_LRU;
+	else if(strcmp(policy, "fifo") == 0)
+		c->policy = GLISS_CACHE_FIFO;
+	else if(strcmp(policy, "random") == 0)
+		c->policy = GLISS_CACHE_RANDOM;
+	else {
+		free(c);
+		return NULL;
+	}
+	snprintf(c->config, sizeof(c->config), "%lu:%lu:%lu:%s", size, ways, line, policy);
+	c->ways = ways;
+	c->set_mask = sets - 1;
+	c->line_bits = __builtin_ctz(line);
+	c->seed = 2463534242u;
+	c->tags = (uint32_t *)malloc(sets * ways * sizeof(uint32_t));
+	c->stamps = (uint64_t *)calloc(sets * ways, sizeof(uint64_t));
+	if(c->tags == NULL || c->stamps == NULL) {
+		free(c->tags);
+		free(c->stamps);
+		free(c);
+		return NULL;
+	}
+	for(i = 0; i < sets * ways; i++)
+		c->tags[i] = INVALID;
+	return c;
+}
+
+
+/**
+ * Release a cache and its counters.
+ * @param c		Released cache (may be NULL).
+ */
+static void cache_delete(gliss_cache_t *c) {
+	site_t *s, *n;
+	int i;
+	if(c == NULL)
+		return;
+	for(i = 0; i < HASH_SIZE; i++) {
+		for(s = c->lines[i]; s != NULL; s = n) {
+			n = s->next;
+			free(s);
+		}
+		for(s = c->insts[i]; s != NULL; s = n) {
+			n = s->next;
+			free(s);
+		}
+	}
+	free(c->tags);
+	free(c->stamps);
+	free(c);
+}
+
+
+/**
+ * Find a tag in a set.
+ * @param t		Tags of the set.
+ * @param ways	Number of ways.
+ * @param tag	Looked tag.
+ * @return		Way holding the tag, -1 if not found.
+ */
+static inline int cache_find(const uint32_t *t, uint32_t ways, uint32_t tag) {
+	uint32_t i;
+#	ifdef __SSE2__
+		if((ways & 3) == 0) {
+			__m128i k = _mm_set1_epi32((int)tag);
+			for(i = 0; i < ways; i += 4) {
+				int m = _mm_movemask_ps(_mm_castsi128_ps(
+					_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(t + i)), k)));
+				if(m != 0)
+					return i + __builtin_ctz(m);
+			}
+			return -1;
+		}
+#	endif
+	for(i = 0; i < ways; i++)
+		if(t[i] == tag)
+			return i;
+	return -1;
+}
+
+
+/**
+ * Look up a line, filling it on a miss.
+ * @param c		Cache.
+ * @param line	Line number (address >> line bits).
+ * @return		1 for a miss, 0 for a hit.
+ */
+static int cache_lookup(gliss_cache_t *c, uint32_t line) {
+	uint32_t base = (line & c->set_mask) * c->ways, i;
+	uint32_t *t = c->tags + base;
+	uint64_t *st = c->stamps + base;
+	int w = cache_find(t, c->ways, line);
+
+	c->clock++;
+	c->acc++;
+	if(w >= 0) {
+		if(c->policy == GLISS_CACHE_LRU)
+			st[w] = c->clock;
+		return 0;
+	}
+	c->miss++;
+
+	/* select the victim */
+	if(c->policy == GLISS_CACHE_RANDOM) {
+		w = cache_find(t, c->ways, INVALID);
+		if(w < 0) {
+			c->seed ^= c->seed << 13;
+			c->seed ^= c->seed >> 17;
+			c->seed ^= c->seed << 5;
+			w = c->seed % c->ways;
+		}
+	}
+	else
+		for(w = 0, i = 1; i < c->ways; i++)
+			if(st[i] < st[w])
+				w = i;
+	t[w] = line;
+	st[w] = c->clock;
+	return 1;
+}
+
+
+/**
+ * Count an access in a hash table of sites.
+ * @param tab	Hash table.
+ * @param addr	Site address.
+ * @param miss	1 for a miss, 0 for a hit.
+ */
+static void count(site_t **tab, uint32_t addr, int miss) {
+	site_t **h = &tab[(addr * 2654435761u) >> (32 - 14)], *s;
+	for(s = *h; s != NULL; s = s->next)
+		if(s->addr == addr)
+			break;
+	if(s == NULL) {
+		s = (site_t *)calloc(1, sizeof(site_t));
+		if(s == NULL)
+			return;
+		s->addr = addr;
+		s->next = *h;
+		*h = s;
+	}
+	s->acc++;
+	s->miss += miss;
+}
+
+
+#ifdef GLISS_MEM_IO
+	/**
+	 * Memory call-back feeding the data cache.
+	 * @param addr			Accessed address.
+	 * @param size			Accessed size.
+	 * @param data			Read / written data.
+	 * @param type_access	Read or write.
+	 * @param cdata			Simulated state.
+	 */
+	static void cache_memory(gliss_address_t addr, int size, void *data, int type_access, void *cdata) {
+		gliss_state_t *state = (gliss_state_t *)cdata;
+		if(state->dcache != NULL && state->spy_quiet == 0)
+			gliss_cache_access(state, addr, size);
+	}
+#endif
+
+
+/**
+ * Initialize the caches of a state, starting them if ARM_ICACHE or
+ * ARM_DCACHE is set.
+ * @param state		Initialized state.
+ */
+void gliss_cache_init(gliss_state_t *state) {
+	const char *icache = getenv("ARM_ICACHE"), *dcache = getenv("ARM_DCACHE");
+	state->icache = NULL;
+	state->dcache = NULL;
+	state->ic_start = 0;
+	state->ic_end = 0;
+	state->cache_pc = 0;
+	state->cache_hooked = 0;
+	if((icache != NULL || dcache != NULL) && gliss_cache_start(state, icache, dcache) != 0)
+		fprintf(stderr, "ERROR: bad cache configuration (size:ways:line[:lru|fifo|random])\n");
+}
+
+
+/**
+ * Start cache simulation (the statistics of a previous simulation are lost).
+ * @param state		Simulated state.
+ * @param icache	Instruction cache configuration (NULL for none).
+ * @param dcache	Data cache configuration (NULL for none, requires WITH_IO).
+ * @return			0 for success, -1 else.
+ */
+int gliss_cache_start(gliss_state_t *state, const char *icache, const char *dcache) {
+	gliss_cache_t *ic = NULL, *dc = NULL;
+
+	if(icache != NULL && (ic = cache_new(icache)) == NULL)
+		return -1;
+	if(dcache != NULL && (dc = cache_new(dcache)) == NULL) {
+		cache_delete(ic);
+		return -1;
+	}
+	gliss_cache_stop(state);
+	state->icache = ic;
+	state->dcache = dc;
+	state->ic_start = 0;
+	state->ic_end = 0;
+
+#	ifdef GLISS_MEM_IO
+		if(dc != NULL && !state->cache_hooked) {
+			gliss_set_range_callback_ex(state->M, 0, 0xffffffff, cache_memory, state, GLISS_MEM_SPY);
+			state->cache_hooked = 1;
+		}
+#	else
+		if(dc != NULL)
+			fprintf(stderr, "WARNING: the data cache requires WITH_IO\n");
+#	endif
+	return 0;
+}
+
+
+/**
+ * Stop cache simulation and release the statistics. If ARM_CACHE_OUT is set,
+ * the statistics are dumped before.
+ * @param state		Simulated state.
+ */
+void gliss_cache_stop(gliss_state_t *state) {
+	const char *path = getenv("ARM_CACHE_OUT");
+	FILE *out;
+
+	if(state->icache == NULL && state->dcache == NULL)
+		return;
+	if(state->icache != NULL)
+		gliss_cache_fetch(state, 0);
+
+	/* dump if required */
+	if(path != NULL) {
+		out = fopen(path, "w");
+		if(out == NULL || gliss_cache_dump(state, getenv("ARM_CACHE_EXE"), getenv("ARM_CACHE_RANGES"), out) != 0)
+			fprintf(stderr, "ERROR: cannot dump cache statistics to %s\n", path);
+		if(out != NULL)
+			fclose(out);
+	}
+
+	/* release */
+	cache_delete(state->icache);
+	cache_delete(state->dcache);
+	state->icache = NULL;
+	state->dcache = NULL;
+}
+
+
+/**
+ * Look up the lines of the current sequential block of instructions in
+ * the instruction cache and start a new block.
+ * @param state		Simulated state.
+ * @param addr		Address of the first instruction of the new block.
+ */
+void gliss_cache_fetch(gliss_state_t *state, uint32_t addr) {
+	gliss_cache_t *c = state->icache;
+	uint32_t l, last, a;
+
+	if(state->ic_end != state->ic_start) {
+		a = state->ic_start;
+		last = (state->ic_end - 1) >> c->line_bits;
+		for(l = a >> c->line_bits; l <= last; l++) {
+			count(c->lines, a, cache_lookup(c, l));
+			a = (l + 1) << c->line_bits;
+		}
+	}
+	state->ic_start = addr;
+	state->ic_end = addr;
+}
+
+
+/**
+ * Look up a memory access in the data cache.
+ * @param state		Simulated state.
+ * @param addr		Accessed address.
+ * @param size		Accessed size (in bytes).
+ */
+void gliss_cache_access(gliss_state_t *state, uint32_t addr, int size) {
+	gliss_cache_t *c = state->dcache;
+	uint32_t l, last = (addr + size - 1) >> c->line_bits;
+	int miss;
+
+	for(l = addr >> c->line_bits; l <= last; l++) {
+		miss = cache_lookup(c, l);
+		count(c->lines, l << c->line_bits, miss);
+		count(c->insts, state->cache_pc, miss);
+	}
+}
+
+
+/**
+ * Comparison function to sort functions by address.
+ */
+static int compare_funcs(const void *f1, const void *f2) {
+	uint32_t a1 = ((const func_t *)f1)->addr, a2 = ((const func_t *)f2)->addr;
+	return a1 < a2 ? -1 : (a1 > a2 ? 1 : 0);
+}
+
+
+/**
+ * Find the function containing an address.
+ * @param funcs		Functions sorted by address.
+ * @param n			Number of functions.
+ * @param addr		Looked address.
+ * @return			Found function or NULL.
+ */
+static func_t *find_func(func_t *funcs, int n, uint32_t addr) {
+	int l = 0, h = n - 1, m;
+	func_t *f = NULL;
+	while(l <= h) {
+		m = (l + h) / 2;
+		if(funcs[m].addr <= addr) {
+			f = &funcs[m];
+			l = m + 1;
+		}
+		else
+			h = m - 1;
+	}
+	if(f != NULL && f->size != 0 && addr >= f->addr + f->size)
+		return NULL;
+	return f;
+}
+
+
+/**
+ * Output the statistics of a cache.
+ * @param c			Cache (may be NULL).
+ * @param name		Cache name.
+ * @param insts		Not null to count the functions by accessing instruction
+ * 					(data cache), null to count them by line.
+ * @param funcs		Functions sorted by address.
+ * @param n			Number of functions.
+ * @param ranges	Address ranges (pairs of low and high address).
+ * @param nr		Number of ranges.
+ * @param out		Output stream.
+ */
+static void dump_cache(gliss_cache_t *c, const char *name, int insts, func_t *funcs, int n,
+uint32_t *ranges, int nr, FILE *out) {
+	uint64_t racc[MAX_RANGES] = { 0 }, rmiss[MAX_RANGES] = { 0 }, uacc = 0, umiss = 0;
+	site_t **tab;
+	site_t *s;
+	func_t *f;
+	int i, j;
+
+	if(c == NULL)
+		return;
+	fprintf(out, "%s,total,%s,%llu,%llu\n", name, c->config,
+		(unsigned long long)c->acc, (unsigned long long)c->miss);
+
+	/* by function */
+	tab = insts ? c->insts : c->lines;
+	for(i = 0; i < n; i++)
+		funcs[i].acc = funcs[i].miss = 0;
+	for(i = 0; i < HASH_SIZE; i++)
+		for(s = tab[i]; s != NULL; s = s->next) {
+			f = find_func(funcs, n, s->addr);
+			if(f != NULL) {
+				f->acc += s->acc;
+				f->miss += s->miss;
+			}
+			else {
+				uacc += s->acc;
+				umiss += s->miss;
+			}
+		}
+	if(n != 0) {
+		for(i = 0; i < n; i++)
+			if(funcs[i].acc != 0)
+				fprintf(out, "%s,function,%s,%llu,%llu\n", name, funcs[i].name,
+					(unsigned long long)funcs[i].acc, (unsigned long long)funcs[i].miss);
+		if(uacc != 0)
+			fprintf(out, "%s,function,?,%llu,%llu\n", name,
+				(unsigned long long)uacc, (unsigned long long)umiss);
+	}
+
+	/* by address range */
+	for(i = 0; i < HASH_SIZE; i++)
+		for(s = c->lines[i]; s != NULL; s = s->next)
+			for(j = 0; j < nr; j++)
+				if(s->addr >= ranges[2 * j] && s->addr < ranges[2 * j + 1]) {
+					racc[j] += s->acc;
+					rmiss[j] += s->miss;
+				}
+	for(j = 0; j < nr; j++)
+		fprintf(out, "%s,range,0x%08x-0x%08x,%llu,%llu\n", name, ranges[2 * j], ranges[2 * j + 1],
+			(unsigned long long)racc[j], (unsigned long long)rmiss[j]);
+}
+
+
+/**
+ * Output the cache statistics in CSV (columns cache, scope, name, accesses
+ * and misses) with one "total" line by cache, followed by "function" lines
+ * (if an executable is given) and "range" lines.
+ * @param state		Simulated state.
+ * @param exe		Path of the executable to get the functions from (may be NULL).
+ * @param ranges	Address ranges, "low-high,..." in hexadecimal (may be NULL).
+ * @param out		Stream to output to.
+ * @return			0 for success, -1 else.
+ */
+int gliss_cache_dump(gliss_state_t *state, const char *exe, const char *ranges, FILE *out) {
+	gliss_loader_t *loader = NULL;
+	uint32_t rs[2 * MAX_RANGES];
+	func_t *funcs = NULL;
+	int n = 0, nr = 0, i;
+	char *p;
+
+	if(state->icache == NULL && state->dcache == NULL)
+		return -1;
+
+	/* parse the ranges */
+	for(p = (char *)ranges; p != NULL && *p != '\0' && nr < MAX_RANGES; nr++) {
+		rs[2 * nr] = strtoul(p, &p, 16);
+		if(*p != '-')
+			return -1;
+		rs[2 * nr + 1] = strtoul(p + 1, &p, 16);
+		if(*p == ',')
+			p++;
+	}
+
+	/* collect the code symbols */
+	if(exe != NULL) {
+		loader = gliss_loader_open(exe);
+		if(loader == NULL)
+			return -1;
+		funcs = (func_t *)malloc(gliss_loader_count_syms(loader) * sizeof(func_t));
+		if(funcs == NULL) {
+			gliss_loader_close(loader);
+			return -1;
+		}
+		for(i = 0; i < gliss_loader_count_syms(loader); i++) {
+			gliss_loader_sym_t sym;
+			gliss_loader_sym(loader, i, &sym);
+			if(sym.type != GLISS_LOADER_SYM_CODE || sym.name == NULL || sym.name[0] == '\0')
+				continue;
+			funcs[n].addr = sym.value & 0xfffffffe;
+			funcs[n].size = sym.size;
+			funcs[n].name = sym.name;
+			n++;
+		}
+		qsort(funcs, n, sizeof(func_t), compare_funcs);
+	}
+
+	fputs("cache,scope,name,accesses,misses\n", out);
+	dump_cache(state->icache, "icache", 0, funcs, n, rs, nr, out);
+	dump_cache(state->dcache, "dcache", 1, funcs, n, rs, nr, out);
+
+	free(funcs);
+	if(loader != NULL)
+		gliss_loader_close(loader);
+	return ferror(out) ? -1 : 0;
+}
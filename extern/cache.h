@@ -0,0 +1,77 @@
+/*!
+ * L1 instruction and data cache simulation
+ *
+ * \file cache.h
+ *
+ * Only linked when WITH_CACHE is configured. Each cache is configured by a
+ * string "size:ways:line[:policy]" (size and line in bytes, powers of two,
+ * policy one of "lru" (default), "fifo" or "random") given to
+ * gliss_cache_start() or, when the state is created, by the environment
+ * variables ARM_ICACHE and ARM_DCACHE.
+ *
+ * The instruction cache is fed by the instruction probe: the probe only
+ * checks whether the instruction follows the previous one and the lines
+ * of a sequential block are looked up at once when the control flow
+ * leaves it. The data cache is fed by the memory accesses seen by the
+ * io_mem hooks, so it requires WITH_IO. Both caches allocate on read and
+ * on write. The accesses the simulator performs for itself (system call
+ * transfers, timing model reads of the instruction image) are not
+ * guest data accesses: they are bracketed by gliss_spy_suspend() and
+ * gliss_spy_resume() (extern/sys_call.h) and ignored by the data cache.
+ *
+ * Hits and misses are counted by line (for address ranges and for the
+ * functions of the instruction cache) and by accessing instruction
+ * (for the functions of the data cache).
+ */
+
+#ifndef GLISS_CACHE_H
+#define GLISS_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+struct gliss_cache_t;
+
+#define GLISS_CACHE_STATE \
+	struct gliss_cache_t *icache; \
+	struct gliss_cache_t *dcache; \
+	uint32_t ic_start; \
+	uint32_t ic_end; \
+	uint32_t cache_pc; \
+	int cache_hooked;
+#define GLISS_CACHE_INIT(s)		gliss_cache_init(s)
+#define GLISS_CACHE_DESTROY(s)	gliss_cache_stop(s)
+
+/* replacement policies */
+#define GLISS_CACHE_LRU			0
+#define GLISS_CACHE_FIFO		1
+#define GLISS_CACHE_RANDOM		2
+
+/* instruction probe: s is the state, a the address, z the size */
+#define gliss_cache_inst(s, a, z) \
+	{ \
+		if((s)->icache != 0) { \
+			if((a) != (s)->ic_end) \
+				gliss_cache_fetch((s), (a)); \
+			(s)->ic_end = (a) + (z); \
+		} \
+		(s)->cache_pc = (a); \
+	}
+
+void gliss_cache_init(struct gliss_state_t *state);
+int gliss_cache_start(struct gliss_state_t *state, const char *icache, const char *dcache);
+void gliss_cache_stop(struct gliss_state_t *state);
+void gliss_cache_fetch(struct gliss_state_t *state, uint32_t addr);
+void gliss_cache_access(struct gliss_state_t *state, uint32_t addr, int size);
+int gliss_cache_dump(struct gliss_state_t *state, const char *exe, const char *ranges, FILE *out);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_CACHE_H */
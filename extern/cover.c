@@ -0,0 +1,185 @@
+/*!
+ * Code coverage bitmap
+ *
+ * \file cover.c
+ *
+ * Marking an instruction only costs a range check on the last used section
+ * (almost always the right one) and one or two bit sets. As bits are only
+ * set, readers do not need any synchronization.
+ *
+ * If the environment variables ARM_COVER_OUT and ARM_COVER_EXE are set when
+ * the state is created, the coverage of the text sections of ARM_COVER_EXE
+ * is recorded in ARM_COVER_OUT.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <gliss/api.h>
+#include <gliss/loader.h>
+#include <gliss/cover.h>
+
+typedef struct sect_t {
+	uint32_t addr;
+	uint32_t size;
+	uint8_t *bits;
+} sect_t;
+
+typedef struct gliss_cover_t {
+	sect_t *last;
+	int cnt;
+	sect_t *sects;
+	uint8_t *map;
+	size_t size;
+} gliss_cover_t;
+
+
+/**
+ * Initialize the coverage of a state, opening it if ARM_COVER_OUT is set.
+ * @param state		Initialized state.
+ */
+void gliss_cover_init(gliss_state_t *state) {
+	const char *path = getenv("ARM_COVER_OUT"), *exe = getenv("ARM_COVER_EXE");
+	state->cover = NULL;
+	if(path != NULL) {
+		if(exe == NULL)
+			fprintf(stderr, "ERROR: ARM_COVER_EXE must give the executable to cover\n");
+		else if(gliss_cover_open(state, exe, path) != 0)
+			fprintf(stderr, "ERROR: cannot open coverage %s for %s\n", path, exe);
+	}
+}
+
+
+/**
+ * Start recording coverage of the text sections of an executable. The bitmap
+ * file is created (or reset if it exists).
+ * @param state		Current state.
+ * @param exe		Path to the simulated executable.
+ * @param path		Path of the bitmap file.
+ * @return			0 for success, -1 else.
+ */
+int gliss_cover_open(gliss_state_t *state, const char *exe, const char *path) {
+	gliss_loader_t *loader;
+	gliss_cover_t *cover;
+	gliss_cover_sect_t *desc;
+	uint32_t offset, cnt = 0, zero = 0;
+	int i, fd;
+
+	gliss_cover_close(state);
+
+	/* collect the text sections */
+	loader = gliss_loader_open(exe);
+	if(loader == NULL)
+		return -1;
+	cover = (gliss_cover_t *)calloc(1, sizeof(gliss_cover_t));
+	if(cover == NULL)
+		goto error_loader;
+	cover->sects = (sect_t *)malloc(gliss_loader_count_sects(loader) * sizeof(sect_t));
+	if(cover->sects == NULL)
+		goto error_cover;
+	for(i = 0; i < gliss_loader_count_sects(loader); i++) {
+		gliss_loader_sect_t data;
+		gliss_loader_sect(loader, i, &data);
+		if(data.type != GLISS_LOADER_SECT_TEXT || data.size == 0)
+			continue;
+		cover->sects[cover->cnt].addr = data.addr;
+		cover->sects[cover->cnt].size = data.size;
+		cover->cnt++;
+	}
+	gliss_loader_close(loader);
+	loader = NULL;
+
+	/* compute the layout */
+	offset = GLISS_COVER_HEADER + cover->cnt * sizeof(gliss_cover_sect_t);
+	cover->size = offset;
+	for(i = 0; i < cover->cnt; i++)
+		cover->size += GLISS_COVER_BYTES(cover->sects[i].size);
+
+	/* build the file */
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if(fd < 0)
+		goto error_cover;
+	if(ftruncate(fd, cover->size) < 0) {
+		close(fd);
+		goto error_cover;
+	}
+	cover->map = (uint8_t *)mmap(NULL, cover->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(cover->map == MAP_FAILED)
+		goto error_cover;
+	cnt = cover->cnt;
+	memcpy(cover->map, GLISS_COVER_MAGIC, 8);
+	memcpy(cover->map + 8, &cnt, 4);
+	memcpy(cover->map + 12, &zero, 4);
+	desc = (gliss_cover_sect_t *)(cover->map + GLISS_COVER_HEADER);
+	for(i = 0; i < cover->cnt; i++) {
+		desc[i].addr = cover->sects[i].addr;
+		desc[i].size = cover->sects[i].size;
+		desc[i].offset = offset;
+		desc[i].pad = 0;
+		cover->sects[i].bits = cover->map + offset;
+		offset += GLISS_COVER_BYTES(cover->sects[i].size);
+	}
+
+	cover->last = cover->cnt != 0 ? &cover->sects[0] : NULL;
+	state->cover = cover;
+	return 0;
+
+error_cover:
+	free(cover->sects);
+	free(cover);
+error_loader:
+	if(loader != NULL)
+		gliss_loader_close(loader);
+	return -1;
+}
+
+
+/**
+ * Stop recording coverage. The bitmap file is kept.
+ * @param state		Current state.
+ */
+void gliss_cover_close(gliss_state_t *state) {
+	gliss_cover_t *cover = state->cover;
+	if(cover == NULL)
+		return;
+	msync(cover->map, cover->size, MS_ASYNC);
+	munmap(cover->map, cover->size);
+	free(cover->sects);
+	free(cover);
+	state->cover = NULL;
+}
+
+
+/**
+ * Mark an instruction as executed.
+ * @param cover		Current coverage.
+ * @param addr		Instruction address.
+ * @param size		Instruction size (2 or 4).
+ */
+void gliss_cover_mark(gliss_cover_t *cover, uint32_t addr, int size) {
+	sect_t *s = cover->last;
+	uint32_t h;
+	int i;
+
+	/* find the section */
+	if(s == NULL || addr - s->addr >= s->size) {
+		for(i = 0; i < cover->cnt; i++)
+			if(addr - cover->sects[i].addr < cover->sects[i].size)
+				break;
+		if(i >= cover->cnt)
+			return;
+		s = cover->last = &cover->sects[i];
+	}
+
+	/* set the bits */
+	h = (addr - s->addr) >> 1;
+	s->bits[h >> 3] |= 1 << (h & 7);
+	if(size == 4 && addr + 2 - s->addr < s->size) {
+		h++;
+		s->bits[h >> 3] |= 1 << (h & 7);
+	}
+}
@@ -0,0 +1,58 @@
+/*!
+ * Code coverage bitmap
+ *
+ * \file cover.h
+ *
+ * Only linked when WITH_COVER is configured. Each halfword of the text
+ * sections of the executable is represented by one bit, set as soon as
+ * an instruction covering it is executed. The bitmap is stored in a file
+ * mapped in memory (use /dev/shm for a memory-only file) so that other
+ * processes can read the coverage while the simulation runs.
+ *
+ * File format (host endianness):
+ *	- header: GLISS_COVER_MAGIC (8 bytes), section count (uint32_t), 0 (uint32_t),
+ *	- section descriptors (gliss_cover_sect_t),
+ *	- section bitmaps (bit i of byte j is the halfword at addr + (j * 8 + i) * 2).
+ */
+
+#ifndef GLISS_COVER_H
+#define GLISS_COVER_H
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+struct gliss_cover_t;
+
+#define GLISS_COVER_STATE		struct gliss_cover_t *cover;
+#define GLISS_COVER_INIT(s)		gliss_cover_init(s)
+#define GLISS_COVER_DESTROY(s)	gliss_cover_close(s)
+
+/* file format */
+#define GLISS_COVER_MAGIC		"GLCOVER1"
+#define GLISS_COVER_HEADER		16
+#define GLISS_COVER_BYTES(size)	(((((size) + 1) / 2 + 63) / 64) * 8)
+
+typedef struct gliss_cover_sect_t {
+	uint32_t addr;		/* section address */
+	uint32_t size;		/* section size (in bytes) */
+	uint32_t offset;	/* bitmap offset in the file */
+	uint32_t pad;
+} gliss_cover_sect_t;
+
+/* instruction probe: s is the state, a the address, z the size */
+#define gliss_cover_inst(s, a, z)	{ if((s)->cover != 0) gliss_cover_mark((s)->cover, (a), (z)); }
+
+void gliss_cover_init(struct gliss_state_t *state);
+int gliss_cover_open(struct gliss_state_t *state, const char *exe, const char *path);
+void gliss_cover_close(struct gliss_state_t *state);
+void gliss_cover_mark(struct gliss_cover_t *cover, uint32_t addr, int size);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_COVER_H */
@@ -0,0 +1,457 @@
+/*!
+ * Event scheduler, interrupt controller and SysTick timer
+ *
+ * \file events.c
+ *
+ * The state counter ev_left is the number of instructions up to the next
+ * deadline (cycles with the timing model, that may overshoot the deadline
+ * and leave a negative count): when it expires, gliss_events_run() calls
+ * the due events and computes the next deadline (the first event of the
+ * heap). While an interrupt line is asserted, the deadline is the next
+ * instruction so that the interrupt is taken as soon as it is unmasked.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/mem.h>
+#include <gliss/events.h>
+
+/* longest distance between two polls */
+#define MAX_SPAN		0x7fffffff
+
+/* interrupt controller registers (PL190 VIC) */
+#define VIC_IRQSTATUS		0x00
+#define VIC_FIQSTATUS		0x04
+#define VIC_RAWINTR			0x08
+#define VIC_INTSELECT		0x0c
+#define VIC_INTENABLE		0x10
+#define VIC_INTENCLEAR		0x14
+#define VIC_SOFTINT			0x18
+#define VIC_SOFTINTCLEAR	0x1c
+#define VIC_SIZE			0x20
+
+/* SysTick registers (offsets from GLISS_SYSTICK_BASE) */
+#define SYST_CSR			0x00
+#define SYST_RVR			0x04
+#define SYST_CVR			0x08
+#define SYST_CALIB			0x0c
+#define SYST_SIZE			0x10
+#define SYST_ENABLE			0x00001
+#define SYST_TICKINT		0x00002
+#define SYST_CLKSOURCE		0x00004
+#define SYST_COUNTFLAG		0x10000
+#define SYST_MASK			0x00ffffff
+
+typedef struct event_t {
+	uint64_t time;
+	uint64_t seq;
+	gliss_event_fun_t fun;
+	void *data;
+} event_t;
+
+typedef struct gliss_events_t {
+	uint64_t deadline;
+	uint64_t seq;
+	event_t *heap;
+	int cnt, cap;
+
+	/* interrupt controller */
+	uint32_t lines, soft, enable, select;
+
+	/* SysTick */
+	uint32_t csr, rvr, cvr;
+	uint64_t fire;
+} gliss_events_t;
+
+
+/* heap order: time, then posting order */
+static inline int before(const event_t *e1, const event_t *e2) {
+	return e1->time < e2->time || (e1->time == e2->time && e1->seq < e2->seq);
+}
+
+static void heap_up(event_t *h, int i) {
+	event_t e = h[i];
+	while(i > 0 && before(&e, &h[(i - 1) / 2])) {
+		h[i] = h[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	h[i] = e;
+}
+
+static void heap_down(event_t *h, int n, int i) {
+	event_t e = h[i];
+	while(2 * i + 1 < n) {
+		int c = 2 * i + 1;
+		if(c + 1 < n && before(&h[c + 1], &h[c]))
+			c++;
+		if(!before(&h[c], &e))
+			break;
+		h[i] = h[c];
+		i = c;
+	}
+	h[i] = e;
+}
+
+
+/* asserted lines */
+static inline uint32_t intc_raw(gliss_events_t *e) {
+	return (e->lines | e->soft) & e->enable;
+}
+
+static inline uint32_t intc_out(gliss_events_t *e) {
+	uint32_t r = intc_raw(e);
+	return ((r & ~e->select) != 0 ? GLISS_EVENTS_IRQ : 0) | ((r & e->select) != 0 ? GLISS_EVENTS_FIQ : 0);
+}
+
+
+/**
+ * Compute the next deadline.
+ * @param state		Current state.
+ * @param now		Current time.
+ */
+static void events_arm(gliss_state_t *state, uint64_t now) {
+	gliss_events_t *e = state->events;
+	uint64_t span = MAX_SPAN;
+	if(intc_out(e) != 0)
+		span = 1;
+	else if(e->cnt > 0) {
+		if(e->heap[0].time <= now)
+			span = 1;
+		else if(e->heap[0].time - now < MAX_SPAN)
+			span = e->heap[0].time - now;
+	}
+	state->ev_left = span;
+	e->deadline = now + span;
+}
+
+
+/**
+ * Get the current simulated time.
+ * @param state		Current state.
+ * @return			Number of executed instructions.
+ */
+uint64_t gliss_events_now(gliss_state_t *state) {
+	if(state->events == NULL)
+		return 0;
+	return state->events->deadline - state->ev_left;
+}
+
+
+/**
+ * Post an event.
+ * @param state		Current state.
+ * @param delay		Delay before the call (in instructions, 0 for the next one).
+ * @param fun		Function to call.
+ * @param data		Argument of the function.
+ * @return			0 for success, -1 else.
+ */
+int gliss_events_post(gliss_state_t *state, uint64_t delay, gliss_event_fun_t fun, void *data) {
+	gliss_events_t *e = state->events;
+	uint64_t now;
+	if(e == NULL)
+		return -1;
+	if(e->cnt == e->cap) {
+		int cap = e->cap == 0 ? 16 : e->cap * 2;
+		event_t *h = (event_t *)realloc(e->heap, cap * sizeof(event_t));
+		if(h == NULL)
+			return -1;
+		e->heap = h;
+		e->cap = cap;
+	}
+	now = gliss_events_now(state);
+	e->heap[e->cnt].time = now + delay;
+	e->heap[e->cnt].seq = e->seq++;
+	e->heap[e->cnt].fun = fun;
+	e->heap[e->cnt].data = data;
+	heap_up(e->heap, e->cnt++);
+	if(now + delay < e->deadline)
+		events_arm(state, now);
+	return 0;
+}
+
+
+/**
+ * Remove the pending events matching a function and an argument.
+ * @param state		Current state.
+ * @param fun		Function of the events.
+ * @param data		Argument of the events.
+ * @return			Number of removed events.
+ */
+int gliss_events_cancel(gliss_state_t *state, gliss_event_fun_t fun, void *data) {
+	gliss_events_t *e = state->events;
+	int i, n = 0;
+	if(e == NULL)
+		return 0;
+	for(i = 0; i < e->cnt; )
+		if(e->heap[i].fun == fun && e->heap[i].data == data) {
+			e->heap[i] = e->heap[--e->cnt];
+			n++;
+		}
+		else
+			i++;
+	for(i = e->cnt / 2 - 1; i >= 0; i--)
+		heap_down(e->heap, e->cnt, i);
+	return n;
+}
+
+
+/**
+ * Call the due events (the counter has expired).
+ * @param state		Current state.
+ * @return			Asserted interrupts (GLISS_EVENTS_IRQ, GLISS_EVENTS_FIQ).
+ */
+uint32_t gliss_events_run(gliss_state_t *state) {
+	gliss_events_t *e = state->events;
+	uint64_t now;
+	if(e == NULL) {
+		state->ev_left = MAX_SPAN;
+		return 0;
+	}
+	now = gliss_events_now(state);
+	e->deadline = now;
+	state->ev_left = 0;
+	while(e->cnt > 0 && e->heap[0].time <= now) {
+		event_t ev = e->heap[0];
+		e->heap[0] = e->heap[--e->cnt];
+		heap_down(e->heap, e->cnt, 0);
+		ev.fun(state, ev.data);
+	}
+	events_arm(state, now);
+	return intc_out(e);
+}
+
+
+/**
+ * Set the level of an interrupt line.
+ * @param state		Current state.
+ * @param line		Line number (0 to GLISS_INTC_LINES - 1).
+ * @param level		Not null to assert, null to deassert.
+ */
+void gliss_intc_set(gliss_state_t *state, int line, int level) {
+	gliss_events_t *e = state->events;
+	if(e == NULL || line < 0 || line >= GLISS_INTC_LINES)
+		return;
+	if(level)
+		e->lines |= 1U << line;
+	else
+		e->lines &= ~(1U << line);
+	events_arm(state, gliss_events_now(state));
+}
+
+
+/**
+ * Enable or disable interrupt lines.
+ * @param state		Current state.
+ * @param lines		Mask of lines.
+ * @param enable	Not null to enable, null to disable.
+ */
+void gliss_intc_enable(gliss_state_t *state, uint32_t lines, int enable) {
+	gliss_events_t *e = state->events;
+	if(e == NULL)
+		return;
+	if(enable)
+		e->enable |= lines;
+	else
+		e->enable &= ~lines;
+	events_arm(state, gliss_events_now(state));
+}
+
+
+/**
+ * Route interrupt lines to FIQ (set bits) or IRQ (cleared bits).
+ * @param state		Current state.
+ * @param fiq_lines	Mask of FIQ lines.
+ */
+void gliss_intc_select(gliss_state_t *state, uint32_t fiq_lines) {
+	gliss_events_t *e = state->events;
+	if(e == NULL)
+		return;
+	e->select = fiq_lines;
+	events_arm(state, gliss_events_now(state));
+}
+
+
+/* SysTick wrap event */
+static void systick_wrap(gliss_state_t *state, void *data) {
+	gliss_events_t *e = state->events;
+	e->csr |= SYST_COUNTFLAG;
+	if(e->csr & SYST_TICKINT)
+		gliss_intc_set(state, GLISS_SYSTICK_LINE, 1);
+	if(e->rvr != 0) {
+		e->fire += e->rvr + 1;
+		gliss_events_post(state, e->fire - gliss_events_now(state), systick_wrap, NULL);
+	}
+	else
+		e->csr &= ~SYST_ENABLE;
+}
+
+/* current value of the SysTick counter */
+static uint32_t systick_value(gliss_state_t *state) {
+	gliss_events_t *e = state->events;
+	if(!(e->csr & SYST_ENABLE))
+		return e->cvr;
+	return (uint32_t)(e->fire - gliss_events_now(state)) & SYST_MASK;
+}
+
+/* (re)start the SysTick counter from its current value, or from the reload
+ * value if reload is set (the counter has been cleared) */
+static void systick_update(gliss_state_t *state, uint32_t csr, int reload) {
+	gliss_events_t *e = state->events;
+	uint64_t now = gliss_events_now(state);
+	if(reload)
+		e->cvr = 0;
+	else if(e->csr & SYST_ENABLE)
+		e->cvr = systick_value(state);
+	gliss_events_cancel(state, systick_wrap, NULL);
+	e->csr = (e->csr & SYST_COUNTFLAG) | (csr & (SYST_ENABLE | SYST_TICKINT | SYST_CLKSOURCE));
+	if(!(e->csr & SYST_TICKINT))
+		gliss_intc_set(state, GLISS_SYSTICK_LINE, 0);
+	if(e->csr & SYST_ENABLE) {
+		e->fire = now + (e->cvr != 0 ? e->cvr : e->rvr + 1);
+		gliss_events_post(state, e->fire - now, systick_wrap, NULL);
+	}
+}
+
+
+/**
+ * Start the SysTick timer: the counter is reloaded and counts down one
+ * per instruction.
+ * @param state		Current state.
+ * @param reload	Reload value (24 bits, 0 to stop the timer).
+ * @param tickint	Not null to assert GLISS_SYSTICK_LINE at each wrap.
+ */
+void gliss_systick_start(gliss_state_t *state, uint32_t reload, int tickint) {
+	gliss_events_t *e = state->events;
+	if(e == NULL)
+		return;
+	e->rvr = reload & SYST_MASK;
+	systick_update(state, reload == 0 ? 0 : SYST_ENABLE | (tickint ? SYST_TICKINT : 0), 1);
+}
+
+
+/* the devices are only mapped when their interrupts can be taken (EXN = in) */
+#if defined(GLISS_MEM_IO) && defined(GLISS_EXN_IN)
+
+	/* read / write a 32-bit register value through a sized access */
+	static void io_read(uint32_t v, gliss_address_t addr, int size, void *data) {
+		v >>= (addr & 3) * 8;
+		memcpy(data, &v, size > 4 ? 4 : size);
+	}
+
+	static uint32_t io_write(uint32_t v, gliss_address_t addr, int size, void *data) {
+		uint32_t w = 0, m = size >= 4 ? 0xffffffff : ((1U << (size * 8)) - 1);
+		memcpy(&w, data, size > 4 ? 4 : size);
+		return (v & ~(m << ((addr & 3) * 8))) | ((w & m) << ((addr & 3) * 8));
+	}
+
+	/**
+	 * Memory call-back of the interrupt controller registers.
+	 * @param addr			Accessed address.
+	 * @param size			Accessed size.
+	 * @param data			Read / written data.
+	 * @param type_access	Read or write.
+	 * @param cdata			Current state.
+	 */
+	static void intc_io(gliss_address_t addr, int size, void *data, int type_access, void *cdata) {
+		gliss_state_t *state = (gliss_state_t *)cdata;
+		gliss_events_t *e = state->events;
+		uint32_t v = 0;
+		switch((addr - GLISS_INTC_BASE) & ~3) {
+		case VIC_IRQSTATUS:		v = intc_raw(e) & ~e->select; break;
+		case VIC_FIQSTATUS:		v = intc_raw(e) & e->select; break;
+		case VIC_RAWINTR:		v = e->lines | e->soft; break;
+		case VIC_INTSELECT:		v = e->select; break;
+		case VIC_INTENABLE:		v = e->enable; break;
+		case VIC_SOFTINT:		v = e->soft; break;
+		}
+		if(type_access == GLISS_MEM_READ) {
+			io_read(v, addr, size, data);
+			return;
+		}
+		v = io_write(0, addr, size, data);
+		switch((addr - GLISS_INTC_BASE) & ~3) {
+		case VIC_INTSELECT:		e->select = io_write(e->select, addr, size, data); break;
+		case VIC_INTENABLE:		e->enable |= v; break;
+		case VIC_INTENCLEAR:	e->enable &= ~v; break;
+		case VIC_SOFTINT:		e->soft |= v; break;
+		case VIC_SOFTINTCLEAR:	e->soft &= ~v; break;
+		}
+		events_arm(state, gliss_events_now(state));
+	}
+
+	/**
+	 * Memory call-back of the SysTick registers.
+	 * @param addr			Accessed address.
+	 * @param size			Accessed size.
+	 * @param data			Read / written data.
+	 * @param type_access	Read or write.
+	 * @param cdata			Current state.
+	 */
+	static void systick_io(gliss_address_t addr, int size, void *data, int type_access, void *cdata) {
+		gliss_state_t *state = (gliss_state_t *)cdata;
+		gliss_events_t *e = state->events;
+		uint32_t off = (addr - GLISS_SYSTICK_BASE) & ~3;
+		if(type_access == GLISS_MEM_READ) {
+			uint32_t v = 0;
+			switch(off) {
+			case SYST_CSR:
+				v = e->csr;
+				e->csr &= ~SYST_COUNTFLAG;
+				gliss_intc_set(state, GLISS_SYSTICK_LINE, 0);
+				break;
+			case SYST_RVR:		v = e->rvr; break;
+			case SYST_CVR:		v = systick_value(state); break;
+			}
+			io_read(v, addr, size, data);
+			return;
+		}
+		switch(off) {
+		case SYST_CSR:
+			systick_update(state, io_write(e->csr, addr, size, data), 0);
+			break;
+		case SYST_RVR:
+			e->rvr = io_write(e->rvr, addr, size, data) & SYST_MASK;
+			break;
+		case SYST_CVR:
+			e->csr &= ~SYST_COUNTFLAG;
+			gliss_intc_set(state, GLISS_SYSTICK_LINE, 0);
+			systick_update(state, e->csr, 1);
+			break;
+		}
+	}
+
+#endif
+
+
+/**
+ * Initialize the event scheduler of a state.
+ * @param state		Initialized state.
+ */
+void gliss_events_init(gliss_state_t *state) {
+	state->events = (gliss_events_t *)calloc(1, sizeof(gliss_events_t));
+	state->ev_left = MAX_SPAN;
+	if(state->events == NULL) {
+		fprintf(stderr, "ERROR: no more memory for the event scheduler\n");
+		return;
+	}
+	state->events->deadline = MAX_SPAN;
+#	if defined(GLISS_MEM_IO) && defined(GLISS_EXN_IN)
+		gliss_set_range_callback(state->M, GLISS_INTC_BASE, GLISS_INTC_BASE + VIC_SIZE - 1, intc_io, state);
+		gliss_set_range_callback(state->M, GLISS_SYSTICK_BASE, GLISS_SYSTICK_BASE + SYST_SIZE - 1, systick_io, state);
+#	endif
+}
+
+
+/**
+ * Release the event scheduler (pending events are dropped).
+ * @param state		Current state.
+ */
+void gliss_events_destroy(gliss_state_t *state) {
+	if(state->events == NULL)
+		return;
+	free(state->events->heap);
+	free(state->events);
+	state->events = NULL;
+}
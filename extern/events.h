@@ -0,0 +1,79 @@
+/*!
+ * Event scheduler, interrupt controller and SysTick timer
+ *
+ * \file events.h
+ *
+ * Events are functions called at a given simulated time, counted in
+ * executed instructions (in cycles with WITH_TIMING, see extern/timing.h).
+ * They are kept in a min-heap and the simulation loop only decrements one
+ * counter per instruction (the distance to the next event), so that the
+ * scheduler costs nothing more when no event is pending. Events are only
+ * polled with the in-simulator exception handling (EXN = in, see
+ * nmp/exn-in.nmp) that takes the IRQ and FIQ asserted by the interrupt
+ * controller between instructions. EXN = in is not available with
+ * WITH_M_PROFILE (no M-profile exception entry): there, the time does not
+ * advance, the SysTick counter does not count and its interrupt
+ * is never taken.
+ *
+ * The interrupt controller has 32 level-sensitive lines, each one routed to
+ * IRQ or FIQ, and its registers follow the PL190 VIC layout. The SysTick
+ * timer counts down once per time unit from its reload value and asserts
+ * GLISS_SYSTICK_LINE when it wraps (if TICKINT is set); reading its control
+ * register (COUNTFLAG) or writing its current value deasserts the line.
+ * With WITH_IO and EXN = in, both devices are mapped at GLISS_INTC_BASE and
+ * GLISS_SYSTICK_BASE; with the other EXN modes, their interrupts cannot be
+ * taken and these addresses are plain memory.
+ */
+
+#ifndef GLISS_EVENTS_H
+#define GLISS_EVENTS_H
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+struct gliss_events_t;
+
+#define GLISS_EVENTS_STATE		int64_t ev_left; struct gliss_events_t *events;
+#define GLISS_EVENTS_INIT(s)	gliss_events_init(s)
+#define GLISS_EVENTS_DESTROY(s)	gliss_events_destroy(s)
+
+/* devices */
+#define GLISS_INTC_BASE			0x10140000
+#define GLISS_INTC_LINES		32
+#define GLISS_SYSTICK_BASE		0xE000E010
+#define GLISS_SYSTICK_LINE		0
+
+/* asserted interrupt lines returned by gliss_events_run() */
+#define GLISS_EVENTS_IRQ		0x1
+#define GLISS_EVENTS_FIQ		0x2
+
+/* accessors used by the execution code (state is in scope) */
+#define gliss_events_due()		(--state->ev_left <= 0)
+#define gliss_events_poll()		gliss_events_run(state)
+
+typedef void (*gliss_event_fun_t)(struct gliss_state_t *state, void *data);
+
+void gliss_events_init(struct gliss_state_t *state);
+void gliss_events_destroy(struct gliss_state_t *state);
+uint32_t gliss_events_run(struct gliss_state_t *state);
+uint64_t gliss_events_now(struct gliss_state_t *state);
+int gliss_events_post(struct gliss_state_t *state, uint64_t delay, gliss_event_fun_t fun, void *data);
+int gliss_events_cancel(struct gliss_state_t *state, gliss_event_fun_t fun, void *data);
+
+/* interrupt controller */
+void gliss_intc_set(struct gliss_state_t *state, int line, int level);
+void gliss_intc_enable(struct gliss_state_t *state, uint32_t lines, int enable);
+void gliss_intc_select(struct gliss_state_t *state, uint32_t fiq_lines);
+
+/* SysTick timer (reload of 0 stops it) */
+void gliss_systick_start(struct gliss_state_t *state, uint32_t reload, int tickint);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_EVENTS_H */
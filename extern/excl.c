@@ -0,0 +1,147 @@
+/*!
+ * Exclusive monitor and memory barriers
+ *
+ * \file excl.c
+ *
+ * The GLISS memory gives no host pointer to the guest memory, so the
+ * compare-and-swap of STREX is made of a read, a comparison and a write
+ * under a host spin lock. The locks are selected by the doubleword address
+ * so that exclusive accesses to different locations do not contend; each
+ * lock protects the version of the granules it covers, bumped by every
+ * store. With WITH_MP, the plain stores take the lock too (gliss_excl_plain())
+ * so that they can neither fall between the read and the write of a STREX
+ * nor leave its version unchanged.
+ */
+
+#include <gliss/api.h>
+#include <gliss/mem.h>
+#include <gliss/excl.h>
+
+#define LOCK_CNT	256
+#define LOCK(a)		(&locks[((a) >> 3) & (LOCK_CNT - 1)])
+
+#define VERSION(a)	(versions[((a) >> 3) & (LOCK_CNT - 1)])
+
+static atomic_flag locks[LOCK_CNT];
+static uint32_t versions[LOCK_CNT];
+
+
+/**
+ * Read a value of the given size.
+ * @param mem	Memory.
+ * @param addr	Address.
+ * @param size	Size (1, 2, 4 or 8).
+ * @return		Read value.
+ */
+static uint64_t read_value(gliss_memory_t *mem, uint32_t addr, int size) {
+	switch(size) {
+	case 1:		return gliss_mem_read8(mem, addr);
+	case 2:		return gliss_mem_read16(mem, addr);
+	case 4:		return gliss_mem_read32(mem, addr);
+	default:	return gliss_mem_read32(mem, addr) | ((uint64_t)gliss_mem_read32(mem, addr + 4) << 32);
+	}
+}
+
+
+/**
+ * Write a value of the given size.
+ * @param mem	Memory.
+ * @param addr	Address.
+ * @param size	Size (1, 2, 4 or 8).
+ * @param val	Written value.
+ */
+static void write_value(gliss_memory_t *mem, uint32_t addr, int size, uint64_t val) {
+	switch(size) {
+	case 1:		gliss_mem_write8(mem, addr, val); break;
+	case 2:		gliss_mem_write16(mem, addr, val); break;
+	case 4:		gliss_mem_write32(mem, addr, val); break;
+	default:
+		gliss_mem_write32(mem, addr, val);
+		gliss_mem_write32(mem, addr + 4, val >> 32);
+		break;
+	}
+}
+
+
+/**
+ * Perform an exclusive load (LDREX*): the value is loaded and recorded
+ * with its address in the local monitor of the state.
+ * @param state		Current state.
+ * @param addr		Loaded address.
+ * @param size		Loaded size (1, 2, 4 or 8).
+ * @return			Loaded value.
+ */
+uint64_t gliss_excl_mark(gliss_state_t *state, uint32_t addr, int size) {
+	atomic_flag *l = LOCK(addr);
+	uint64_t v;
+	while(atomic_flag_test_and_set_explicit(l, memory_order_acquire))
+		;
+	v = read_value(state->M, addr, size);
+	state->excl_ver = VERSION(addr);
+	atomic_flag_clear_explicit(l, memory_order_release);
+	state->excl_addr = addr;
+	state->excl_size = size;
+	state->excl_val = v;
+	return v;
+}
+
+
+/**
+ * Perform an exclusive store (STREX*) and clear the local monitor.
+ * @param state		Current state.
+ * @param addr		Stored address.
+ * @param size		Stored size (1, 2, 4 or 8).
+ * @param val		Stored value.
+ * @return			0 if the store is done, 1 else (as written in Rd).
+ */
+uint32_t gliss_excl_cas(gliss_state_t *state, uint32_t addr, int size, uint64_t val) {
+	atomic_flag *l = LOCK(addr);
+	uint32_t r = 1;
+
+	if(state->excl_size == (uint32_t)size && state->excl_addr == addr) {
+		while(atomic_flag_test_and_set_explicit(l, memory_order_acquire))
+			;
+		if(VERSION(addr) == state->excl_ver && read_value(state->M, addr, size) == state->excl_val) {
+			write_value(state->M, addr, size, val);
+			VERSION(addr)++;
+			r = 0;
+		}
+		atomic_flag_clear_explicit(l, memory_order_release);
+	}
+	state->excl_size = 0;
+	return r;
+}
+
+
+/**
+ * Perform a plain store (used instead of the memory write with WITH_MP):
+ * the store is done under the lock of the granule, or of both granules for
+ * an unaligned store crossing them, and bumps their version so that the
+ * pending STREX of any core to these granules fail.
+ * @param state		Current state.
+ * @param addr		Stored address.
+ * @param size		Stored size (1, 2, 4 or 8).
+ * @param val		Stored value.
+ */
+void gliss_excl_plain(gliss_state_t *state, uint32_t addr, int size, uint64_t val) {
+	atomic_flag *l1 = LOCK(addr), *l2 = LOCK(addr + size - 1);
+
+	/* always lock in the same order to avoid dead locks */
+	if(l2 < l1) {
+		atomic_flag *t = l1;
+		l1 = l2;
+		l2 = t;
+	}
+	while(atomic_flag_test_and_set_explicit(l1, memory_order_acquire))
+		;
+	if(l2 != l1)
+		while(atomic_flag_test_and_set_explicit(l2, memory_order_acquire))
+			;
+	write_value(state->M, addr, size, val);
+	VERSION(addr)++;
+	if(l2 != l1) {
+		VERSION(addr + size - 1)++;
+		atomic_flag_clear_explicit(l2, memory_order_release);
+	}
+	atomic_flag_clear_explicit(l1, memory_order_release);
+}
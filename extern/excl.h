@@ -0,0 +1,63 @@
+/*!
+ * Exclusive monitor and memory barriers
+ *
+ * \file excl.h
+ *
+ * Each state (core) has a local monitor made of the address, the size, the
+ * value and the granule version of its last LDREX. The global monitor is a
+ * version per doubleword granule (hashed in LOCK_CNT stripes, see
+ * extern/excl.c) bumped by every store to the granule: a STREX succeeds if
+ * the local monitor matches, the version did not change and the memory still
+ * holds the loaded value, the check and the store being one atomic operation
+ * for all the cores sharing the memory.
+ *
+ * With WITH_MP, the plain stores (gliss_excl_write()) are performed under
+ * the same lock and bump the version: a store of another core, even of the
+ * loaded value, makes the pending STREX fail and is never lost. Without it,
+ * they are plain memory writes (single core).
+ *
+ * DMB and DSB are host memory fences.
+ */
+
+#ifndef GLISS_EXCL_H
+#define GLISS_EXCL_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <gliss/config.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+
+#define GLISS_EXCL_STATE		uint32_t excl_addr; uint32_t excl_size; uint64_t excl_val; uint32_t excl_ver;
+#define GLISS_EXCL_INIT(s)		(s)->excl_size = 0
+#define GLISS_EXCL_DESTROY(s)
+
+/* accessors used by the execution code (state is in scope) */
+#define gliss_excl_load(a, z)		((uint32_t)gliss_excl_mark(state, (a), (z)))
+#define gliss_excl_load64(a)		gliss_excl_mark(state, (a), 8)
+#define gliss_excl_store(a, z, v)	gliss_excl_cas(state, (a), (z), (v))
+#define gliss_excl_clear()			(state->excl_size = 0)
+#define gliss_excl_fence()			atomic_thread_fence(memory_order_seq_cst)
+#ifdef GLISS_MP
+#	define gliss_excl_write(a, z, v)	gliss_excl_plain(state, (a), (z), (v))
+#else
+#	define gliss_excl_write(a, z, v) \
+		((z) == 1 ? gliss_mem_write8(state->M, (a), (v)) : \
+		(z) == 2 ? gliss_mem_write16(state->M, (a), (v)) : \
+		(z) == 4 ? gliss_mem_write32(state->M, (a), (v)) : \
+		(gliss_mem_write32(state->M, (a), (v)), gliss_mem_write32(state->M, (a) + 4, (uint64_t)(v) >> 32)))
+#endif
+
+uint64_t gliss_excl_mark(struct gliss_state_t *state, uint32_t addr, int size);
+uint32_t gliss_excl_cas(struct gliss_state_t *state, uint32_t addr, int size, uint64_t val);
+void gliss_excl_plain(struct gliss_state_t *state, uint32_t addr, int size, uint64_t val);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_EXCL_H */
@@ -0,0 +1,148 @@
+/*!
+ * Superinstruction fusion control and counters
+ *
+ * \file fuse.c
+ *
+ * The breakpoints are few and only looked up when a pair is about to be
+ * fused, so a linear search is enough.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/fuse.h>
+
+static const char *kind_names[GLISS_FUSE_KINDS] = {
+	"cmp-b",
+	"movw-movt"
+};
+
+
+/**
+ * Initialize the fusion of a new state: enabled unless ARM_FUSE is "0".
+ * @param state		Initialized state.
+ */
+void gliss_fuse_init(gliss_state_t *state) {
+	const char *on = getenv("ARM_FUSE");
+	memset(state->fuse_cnt, 0, sizeof(state->fuse_cnt));
+	state->fuse_on = on == NULL || strcmp(on, "0") != 0;
+	state->fuse_break_cnt = 0;
+}
+
+
+/**
+ * Dump the counters if required by ARM_FUSE_OUT.
+ * @param state		Destroyed state.
+ */
+void gliss_fuse_destroy(gliss_state_t *state) {
+	const char *path = getenv("ARM_FUSE_OUT");
+	FILE *out;
+	if(path == NULL)
+		return;
+	out = fopen(path, "w");
+	if(out == NULL) {
+		fprintf(stderr, "ERROR: cannot dump fusion counters to %s\n", path);
+		return;
+	}
+	gliss_fuse_dump_csv(state, out);
+	fclose(out);
+}
+
+
+/**
+ * Enable or disable the fusion.
+ * @param state		Current state.
+ * @param on		Non-zero to enable, 0 to disable.
+ */
+void gliss_fuse_enable(gliss_state_t *state, int on) {
+	state->fuse_on = on;
+}
+
+
+/**
+ * Prevent fusion of the instruction at the given address with the previous
+ * one, so that it is executed (and observed) alone.
+ * @param state		Current state.
+ * @param addr		Breakpoint address.
+ * @return			0 for success, -1 if there are too many breakpoints.
+ */
+int gliss_fuse_break(gliss_state_t *state, uint32_t addr) {
+	if(gliss_fuse_check(state, addr) == 0)
+		return 0;
+	if(state->fuse_break_cnt == GLISS_FUSE_MAX_BREAKS)
+		return -1;
+	state->fuse_break[state->fuse_break_cnt++] = addr;
+	return 0;
+}
+
+
+/**
+ * Remove a breakpoint set by gliss_fuse_break().
+ * @param state		Current state.
+ * @param addr		Breakpoint address.
+ */
+void gliss_fuse_unbreak(gliss_state_t *state, uint32_t addr) {
+	int i;
+	for(i = 0; i < state->fuse_break_cnt; i++)
+		if(state->fuse_break[i] == addr) {
+			state->fuse_break[i] = state->fuse_break[--state->fuse_break_cnt];
+			return;
+		}
+}
+
+
+/**
+ * Test if an instruction may be fused with the previous one.
+ * @param state		Current state.
+ * @param addr		Address of the instruction.
+ * @return			0 if there is a breakpoint at addr, 1 else.
+ */
+int gliss_fuse_check(gliss_state_t *state, uint32_t addr) {
+	int i;
+	for(i = 0; i < state->fuse_break_cnt; i++)
+		if(state->fuse_break[i] == addr)
+			return 0;
+	return 1;
+}
+
+
+/**
+ * Get the number of fused pairs of a kind.
+ * @param state		Current state.
+ * @param kind		Kind of pair (GLISS_FUSE_XXX).
+ * @return			Number of hits.
+ */
+uint64_t gliss_fuse_hits(gliss_state_t *state, int kind) {
+	if(kind < 0 || kind >= GLISS_FUSE_KINDS)
+		return 0;
+	return state->fuse_cnt[kind][1];
+}
+
+
+/**
+ * Get the number of times the first instruction of a pair was not followed
+ * by the second one.
+ * @param state		Current state.
+ * @param kind		Kind of pair (GLISS_FUSE_XXX).
+ * @return			Number of misses.
+ */
+uint64_t gliss_fuse_misses(gliss_state_t *state, int kind) {
+	if(kind < 0 || kind >= GLISS_FUSE_KINDS)
+		return 0;
+	return state->fuse_cnt[kind][0];
+}
+
+
+/**
+ * Dump the counters as CSV: one line "kind,hits,misses" by kind of pair.
+ * @param state		Current state.
+ * @param out		Stream to output to.
+ */
+void gliss_fuse_dump_csv(gliss_state_t *state, FILE *out) {
+	int i;
+	fprintf(out, "kind,hits,misses\n");
+	for(i = 0; i < GLISS_FUSE_KINDS; i++)
+		fprintf(out, "%s,%llu,%llu\n", kind_names[i],
+			(unsigned long long)state->fuse_cnt[i][1],
+			(unsigned long long)state->fuse_cnt[i][0]);
+}
@@ -0,0 +1,68 @@
+/*!
+ * Superinstruction fusion control and counters
+ *
+ * \file fuse.h
+ *
+ * Only linked when WITH_FUSION is configured (and no instrumentation
+ * probe is): the first instruction of a fused pair (see nmp/fuse-on.nmp)
+ * asks gliss_fuse_allowed() before executing the second one and counts
+ * the hits and misses of its kind.
+ *
+ * Fusion is refused at the addresses set with gliss_fuse_break(), so that
+ * a debugger stops on each instruction it put a breakpoint on, and can be
+ * disabled altogether with gliss_fuse_enable() (for example to step in
+ * lock-step with another simulator) or with the environment variable
+ * ARM_FUSE=0 when the state is created.
+ *
+ * If the environment variable ARM_FUSE_OUT is set when the state is
+ * created, the counters are dumped to the named file when the state is
+ * destroyed (CSV "kind,hits,misses").
+ */
+
+#ifndef GLISS_FUSE_H
+#define GLISS_FUSE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+
+/* fused pairs (FUSE_XXX in nmp/fuse-on.nmp) */
+#define GLISS_FUSE_CMP_B		0
+#define GLISS_FUSE_MOVW_MOVT	1
+#define GLISS_FUSE_KINDS		2
+
+#define GLISS_FUSE_MAX_BREAKS	8
+
+#define GLISS_FUSE_STATE \
+	uint64_t fuse_cnt[GLISS_FUSE_KINDS][2]; \
+	int fuse_on; \
+	int fuse_break_cnt; \
+	uint32_t fuse_break[GLISS_FUSE_MAX_BREAKS];
+#define GLISS_FUSE_INIT(s)		gliss_fuse_init(s)
+#define GLISS_FUSE_DESTROY(s)	gliss_fuse_destroy(s)
+
+/* accessors used by the execution code (state is in scope) */
+#define gliss_fuse_allowed(a) \
+	(state->fuse_on && (state->fuse_break_cnt == 0 || gliss_fuse_check(state, (a))))
+#define gliss_fuse_count(k, h)	(state->fuse_cnt[k][h]++)
+
+void gliss_fuse_init(struct gliss_state_t *state);
+void gliss_fuse_destroy(struct gliss_state_t *state);
+void gliss_fuse_enable(struct gliss_state_t *state, int on);
+int gliss_fuse_break(struct gliss_state_t *state, uint32_t addr);
+void gliss_fuse_unbreak(struct gliss_state_t *state, uint32_t addr);
+int gliss_fuse_check(struct gliss_state_t *state, uint32_t addr);
+uint64_t gliss_fuse_hits(struct gliss_state_t *state, int kind);
+uint64_t gliss_fuse_misses(struct gliss_state_t *state, int kind);
+void gliss_fuse_dump_csv(struct gliss_state_t *state, FILE *out);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_FUSE_H */
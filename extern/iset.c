@@ -0,0 +1,45 @@
+/*!
+ * Decoding table of the current instruction set
+ *
+ * \file iset.c
+ *
+ * The indexes of the ARM and Thumb tables in gliss_modes are looked up by
+ * name on the first update. Without a mode table, the index stays 0.
+ */
+
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/iset.h>
+
+/* instruction set bit of APSR */
+#define THUMB_BIT	(1 << 5)
+
+static int looked_up = 0, arm_iset = 0, thumb_iset = 0;
+
+
+/**
+ * Look for the tables of the instruction sets in gliss_modes.
+ */
+static void look_up(void) {
+	int i;
+	for(i = 0; gliss_modes[i].name != NULL; i++)
+		if(strcmp(gliss_modes[i].name, "ARM") == 0)
+			arm_iset = i;
+		else if(strcmp(gliss_modes[i].name, "THUMB") == 0)
+			thumb_iset = i;
+	looked_up = 1;
+}
+
+
+/**
+ * Select the decoding table of the current instruction set of the state.
+ * Called by the instructions changing TFLAG; must also be called by the
+ * tools after the creation of the state (the entry point may set TFLAG
+ * after the initialization) or after changing APSR themselves.
+ * @param state		State to update.
+ */
+void gliss_iset_update(gliss_state_t *state) {
+	if(!looked_up)
+		look_up();
+	state->iset = (state->APSR & THUMB_BIT) ? thumb_iset : arm_iset;
+}
@@ -0,0 +1,43 @@
+/*!
+ * Decoding table of the current instruction set
+ *
+ * \file iset.h
+ *
+ * GLISS generates one decoding table per instruction set (gliss_modes[],
+ * "ARM" and "THUMB") and gliss_decode() selects one of them by testing TFLAG
+ * at each decoding. This module keeps in the state the index in gliss_modes
+ * of the table of the current instruction set. It is only updated by the
+ * instructions changing TFLAG (canon "arm_iset_switch" of nmp/gen.nmp):
+ * BX, BLX, the loads to PC (LDR, LDM, POP), the exception entries (EXN = in)
+ * and returns (CPSR restored from SPSR) and the reset.
+ *
+ * A loop driving the decoder itself decodes with
+ * gliss_modes[state->iset].decode(decoder, address), without selection
+ * (see batch/arm-batch.c). gliss_step() still decodes with gliss_decode().
+ * Builds with a single instruction set (WITH_M_PROFILE) have no mode table
+ * (gliss_modes[0].name is NULL) and must use gliss_decode().
+ */
+
+#ifndef GLISS_ISET_H
+#define GLISS_ISET_H
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+
+#define GLISS_ISET_STATE		int iset;
+#define GLISS_ISET_INIT(s)		gliss_iset_update(s)
+#define GLISS_ISET_DESTROY(s)
+
+/* accessor used by the execution code (state is in scope) */
+#define gliss_iset_switch()		gliss_iset_update(state)
+
+void gliss_iset_update(struct gliss_state_t *state);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_ISET_H */
@@ -0,0 +1,316 @@
+/*!
+ * Sampling profiler
+ *
+ * \file prof.c
+ *
+ * Call and return probes only record a pending event: it is processed
+ * at the next instruction whose address is the called function entry or
+ * the return address. On return, the shadow stack is popped up to the frame
+ * matching the return address so that tail calls or non-local jumps do not
+ * de-synchronize it (a return matching no frame is ignored).
+ *
+ * A sample is made of the call sites of the stack and of the current PC
+ * so that the function performing the first call is also in the stack.
+ *
+ * If the environment variable ARM_PROFILE_OUT is set when the state is
+ * created, the profiler is started (period given by ARM_PROFILE_PERIOD,
+ * default DEFAULT_PERIOD) and the folded stacks are output to the named
+ * file when the state is destroyed, resolved with the symbols of the
+ * executable given by ARM_PROFILE_EXE.
+ *
+ * With the timing model (WITH_TIMING), a sample counts the cycles elapsed
+ * since the previous sample instead of 1 so that the profile shows where
+ * the time is spent rather than where the instructions are executed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/loader.h>
+#include <gliss/prof.h>
+#ifdef GLISS_TIMING
+#	include <gliss/timing.h>
+#endif
+
+#define DEFAULT_PERIOD	1000
+#define MAX_DEPTH		256
+#define HASH_SIZE		4096
+#define NO_SAMPLE		0xffffffff
+
+typedef struct sample_t {
+	struct sample_t *next;
+	uint32_t hash;
+	uint64_t cnt;
+	int len;
+	uint32_t addrs[];
+} sample_t;
+
+typedef struct gliss_prof_t {
+	uint32_t period;
+	int depth;					/* may be greater than MAX_DEPTH */
+	uint32_t rets[MAX_DEPTH];	/* return addresses */
+	uint64_t last;				/* cycles at the previous sample */
+	sample_t *samples[HASH_SIZE];
+} gliss_prof_t;
+
+typedef struct func_t {
+	uint32_t addr;
+	uint32_t size;
+	const char *name;
+} func_t;
+
+
+/**
+ * Initialize the profiler of a state, starting it if ARM_PROFILE_OUT is set.
+ * @param state		Initialized state.
+ */
+void gliss_prof_init(gliss_state_t *state) {
+	const char *period;
+	state->prof = NULL;
+	state->prof_count = NO_SAMPLE;
+	state->prof_ret = 0;
+	state->prof_event = 0;
+	if(getenv("ARM_PROFILE_OUT") != NULL) {
+		period = getenv("ARM_PROFILE_PERIOD");
+		if(gliss_prof_start(state, period == NULL ? DEFAULT_PERIOD : strtoul(period, NULL, 0)) != 0)
+			fprintf(stderr, "ERROR: cannot start the profiler\n");
+	}
+}
+
+
+/**
+ * Start profiling (samples of a previous profiling are lost).
+ * @param state		Profiled state.
+ * @param period	Sampling period (in instructions).
+ * @return			0 for success, -1 else.
+ */
+int gliss_prof_start(gliss_state_t *state, uint32_t period) {
+	if(period == 0)
+		return -1;
+	gliss_prof_stop(state);
+	state->prof = (gliss_prof_t *)calloc(1, sizeof(gliss_prof_t));
+	if(state->prof == NULL)
+		return -1;
+	state->prof->period = period;
+#	ifdef GLISS_TIMING
+		state->prof->last = gliss_timing_cycles(state);
+#	endif
+	state->prof_count = period;
+	return 0;
+}
+
+
+/**
+ * Stop profiling and release the samples. If ARM_PROFILE_OUT is set,
+ * the samples are dumped before.
+ * @param state		Profiled state.
+ */
+void gliss_prof_stop(gliss_state_t *state) {
+	gliss_prof_t *prof = state->prof;
+	const char *path = getenv("ARM_PROFILE_OUT");
+	sample_t *s, *n;
+	FILE *out;
+	int i;
+
+	if(prof == NULL)
+		return;
+
+	/* dump if required */
+	if(path != NULL) {
+		out = fopen(path, "w");
+		if(out == NULL || gliss_prof_dump(state, getenv("ARM_PROFILE_EXE"), out) != 0)
+			fprintf(stderr, "ERROR: cannot dump profile to %s\n", path);
+		if(out != NULL)
+			fclose(out);
+	}
+
+	/* release */
+	for(i = 0; i < HASH_SIZE; i++)
+		for(s = prof->samples[i]; s != NULL; s = n) {
+			n = s->next;
+			free(s);
+		}
+	free(prof);
+	state->prof = NULL;
+	state->prof_count = NO_SAMPLE;
+}
+
+
+/**
+ * Process a pending call or return.
+ * @param state		Current state.
+ * @param addr		Address of the first instruction after the event.
+ */
+void gliss_prof_event(gliss_state_t *state, uint32_t addr) {
+	gliss_prof_t *prof = state->prof;
+	int i;
+
+	if(prof != NULL) {
+		if(state->prof_event == GLISS_PROF_CALL) {
+			if(prof->depth < MAX_DEPTH)
+				prof->rets[prof->depth] = state->prof_ret;
+			prof->depth++;
+		}
+		else if(prof->depth > MAX_DEPTH)
+			prof->depth--;
+		else
+			for(i = prof->depth - 1; i >= 0; i--)
+				if(prof->rets[i] == addr) {
+					prof->depth = i;
+					break;
+				}
+	}
+	state->prof_event = 0;
+}
+
+
+/**
+ * Record a sample.
+ * @param state		Current state.
+ * @param addr		Current instruction address.
+ */
+void gliss_prof_sample(gliss_state_t *state, uint32_t addr) {
+	gliss_prof_t *prof = state->prof;
+	uint32_t hash = 2166136261u;
+	uint64_t w = 1;
+	sample_t *s;
+	int i, len;
+
+	if(prof == NULL) {
+		state->prof_count = NO_SAMPLE;
+		return;
+	}
+	state->prof_count = prof->period;
+#	ifdef GLISS_TIMING
+		w = gliss_timing_cycles(state) - prof->last;
+		prof->last = gliss_timing_cycles(state);
+#	endif
+
+	/* compute the hash */
+	len = prof->depth < MAX_DEPTH ? prof->depth : MAX_DEPTH;
+	for(i = 0; i < len; i++)
+		hash = (hash ^ prof->rets[i]) * 16777619u;
+	hash = (hash ^ addr) * 16777619u;
+
+	/* look for the sample */
+	for(s = prof->samples[hash % HASH_SIZE]; s != NULL; s = s->next)
+		if(s->hash == hash && s->len == len + 1 && s->addrs[len] == addr) {
+			for(i = 0; i < len; i++)
+				if(s->addrs[i] != prof->rets[i] - 2)
+					break;
+			if(i == len) {
+				s->cnt += w;
+				return;
+			}
+		}
+
+	/* create it */
+	s = (sample_t *)malloc(sizeof(sample_t) + (len + 1) * sizeof(uint32_t));
+	if(s == NULL)
+		return;
+	s->hash = hash;
+	s->cnt = w;
+	s->len = len + 1;
+	for(i = 0; i < len; i++)
+		s->addrs[i] = prof->rets[i] - 2;
+	s->addrs[len] = addr;
+	s->next = prof->samples[hash % HASH_SIZE];
+	prof->samples[hash % HASH_SIZE] = s;
+}
+
+
+/**
+ * Comparison function to sort functions by address.
+ */
+static int compare_funcs(const void *f1, const void *f2) {
+	uint32_t a1 = ((const func_t *)f1)->addr, a2 = ((const func_t *)f2)->addr;
+	return a1 < a2 ? -1 : (a1 > a2 ? 1 : 0);
+}
+
+
+/**
+ * Find the function containing an address.
+ * @param funcs		Functions sorted by address.
+ * @param n			Number of functions.
+ * @param addr		Looked address.
+ * @return			Found function or NULL.
+ */
+static func_t *find_func(func_t *funcs, int n, uint32_t addr) {
+	int l = 0, h = n - 1, m;
+	func_t *f = NULL;
+	while(l <= h) {
+		m = (l + h) / 2;
+		if(funcs[m].addr <= addr) {
+			f = &funcs[m];
+			l = m + 1;
+		}
+		else
+			h = m - 1;
+	}
+	if(f != NULL && f->size != 0 && addr >= f->addr + f->size)
+		return NULL;
+	return f;
+}
+
+
+/**
+ * Output the samples as folded stacks.
+ * @param state		Profiled state.
+ * @param exe		Path of the executable to get symbols from (may be NULL,
+ * 					addresses are then output in hexadecimal).
+ * @param out		Stream to output to.
+ * @return			0 for success, -1 else.
+ */
+int gliss_prof_dump(gliss_state_t *state, const char *exe, FILE *out) {
+	gliss_prof_t *prof = state->prof;
+	gliss_loader_t *loader = NULL;
+	func_t *funcs = NULL, *f;
+	int n = 0, i, j;
+	sample_t *s;
+
+	if(prof == NULL)
+		return -1;
+
+	/* collect the code symbols */
+	if(exe != NULL) {
+		loader = gliss_loader_open(exe);
+		if(loader == NULL)
+			return -1;
+		funcs = (func_t *)malloc(gliss_loader_count_syms(loader) * sizeof(func_t));
+		if(funcs == NULL) {
+			gliss_loader_close(loader);
+			return -1;
+		}
+		for(i = 0; i < gliss_loader_count_syms(loader); i++) {
+			gliss_loader_sym_t sym;
+			gliss_loader_sym(loader, i, &sym);
+			if(sym.type != GLISS_LOADER_SYM_CODE || sym.name == NULL || sym.name[0] == '\0')
+				continue;
+			funcs[n].addr = sym.value & 0xfffffffe;
+			funcs[n].size = sym.size;
+			funcs[n].name = sym.name;
+			n++;
+		}
+		qsort(funcs, n, sizeof(func_t), compare_funcs);
+	}
+
+	/* output the stacks */
+	for(i = 0; i < HASH_SIZE; i++)
+		for(s = prof->samples[i]; s != NULL; s = s->next) {
+			for(j = 0; j < s->len; j++) {
+				if(j != 0)
+					fputc(';', out);
+				f = find_func(funcs, n, s->addrs[j]);
+				if(f != NULL)
+					fputs(f->name, out);
+				else
+					fprintf(out, "0x%08x", s->addrs[j]);
+			}
+			fprintf(out, " %llu\n", (unsigned long long)s->cnt);
+		}
+
+	free(funcs);
+	if(loader != NULL)
+		gliss_loader_close(loader);
+	return 0;
+}
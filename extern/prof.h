@@ -0,0 +1,58 @@
+/*!
+ * Sampling profiler
+ *
+ * \file prof.h
+ *
+ * Only linked when WITH_PROFILE is configured. The profiler maintains a shadow
+ * call stack from the call and return probes and, every period instructions,
+ * records a sample made of the current stack and PC. Samples are output
+ * as folded stacks ("f1;f2;f3 count" lines), the format used by the
+ * flame graph tools, using the symbols of the executable.
+ */
+
+#ifndef GLISS_PROF_H
+#define GLISS_PROF_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+struct gliss_prof_t;
+
+#define GLISS_PROF_STATE \
+	struct gliss_prof_t *prof; \
+	uint32_t prof_count; \
+	uint32_t prof_ret; \
+	int prof_event;
+#define GLISS_PROF_INIT(s)		gliss_prof_init(s)
+#define GLISS_PROF_DESTROY(s)	gliss_prof_stop(s)
+
+/* pending events (processed at the next instruction) */
+#define GLISS_PROF_CALL			1
+#define GLISS_PROF_RETURN		2
+
+/* probes: s is the state, a the instruction address, r the return address */
+#define gliss_prof_inst(s, a) \
+	{ \
+		if((s)->prof_event) gliss_prof_event((s), (a)); \
+		if(--(s)->prof_count == 0) gliss_prof_sample((s), (a)); \
+	}
+#define gliss_prof_call(s, r)	{ (s)->prof_event = GLISS_PROF_CALL; (s)->prof_ret = (r); }
+#define gliss_prof_return(s)	{ (s)->prof_event = GLISS_PROF_RETURN; }
+
+void gliss_prof_init(struct gliss_state_t *state);
+int gliss_prof_start(struct gliss_state_t *state, uint32_t period);
+void gliss_prof_stop(struct gliss_state_t *state);
+void gliss_prof_event(struct gliss_state_t *state, uint32_t addr);
+void gliss_prof_sample(struct gliss_state_t *state, uint32_t addr);
+int gliss_prof_dump(struct gliss_state_t *state, const char *exe, FILE *out);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_PROF_H */
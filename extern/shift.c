@@ -17,12 +17,14 @@
 #include <arm/shift.h>
 #endif
 
-/* store current carry flag */
-static volatile uint8_t CARRY_FLAG_SHIFT_ONLY = 0;
-static volatile uint8_t ITSTATE_FOR_SYNTAX = 0;
-static volatile uint8_t ITCOND_FOR_SYNTAX = 0;
-static volatile uint8_t ITBLOCK_FOR_SYNTAX = 0;
-static volatile uint8_t ITBLOCK_BASE_CONDITION_FOR_SYNTAX = 0;
+/* store current carry flag (one per thread as several cores may execute) */
+static _Thread_local uint8_t CARRY_FLAG_SHIFT_ONLY = 0;
+
+/* ITSTATE of the disassembled instruction: set by the IT instruction and
+ * advanced by each instruction of the block as in the execution (ITAdvance),
+ * so that ITSTATE<7..4> is the condition of the current instruction.
+ * One per thread so that several disassemblers may run concurrently. */
+static _Thread_local uint8_t ITSTATE_FOR_SYNTAX = 0;
 
 uint8_t f_get_ITSTATE(void)
 {
@@ -32,102 +34,18 @@ uint8_t f_get_ITSTATE(void)
 uint8_t f_get_update_ITSTATE(void)
 {
 	uint8_t tmp = ITSTATE_FOR_SYNTAX;
-	uint8_t tmp_condition = ITBLOCK_BASE_CONDITION_FOR_SYNTAX;
-
-	// update condition depending on then/else (e.g., eq -> ne)
-	//if ((ITBLOCK_FOR_SYNTAX & 0b11000000) == 0b10000000) 	// then -> no condition change!
-	if ((ITBLOCK_FOR_SYNTAX & 0b11000000) == 0b01000000)	// else -> change base condition!
-	{
-		if (tmp_condition % 2 == 0)
-		{
-			tmp_condition++;
-		}
-		else
-		{
-			tmp_condition--;
-		}
-	}
 
-	ITBLOCK_FOR_SYNTAX = ITBLOCK_FOR_SYNTAX << 2;
-
-	if ((ITSTATE_FOR_SYNTAX & 0b00000111) == 0 )
-	{
+	if ((ITSTATE_FOR_SYNTAX & 0b00000111) == 0)
 		ITSTATE_FOR_SYNTAX = 0;
-	}
 	else
-	{
-		ITSTATE_FOR_SYNTAX =  (tmp_condition << 4) | (0b00001111 & (ITSTATE_FOR_SYNTAX << 1));
-	}
+		ITSTATE_FOR_SYNTAX = (ITSTATE_FOR_SYNTAX & 0b11100000) | ((ITSTATE_FOR_SYNTAX << 1) & 0b00011111);
 
 	return tmp;
 }
 
-/*
-if t(then)... e(else)...
-t = 10
-e = 01
-none = 00
-
-*/
-void f_calc_condition_ITSTATE(void)
-{
-	if ((ITSTATE_FOR_SYNTAX & 0b00001111) == 8)
-	{
-		ITBLOCK_FOR_SYNTAX = 0b00000000; // last condition, no changes else
-	}
-	else
-	{
-		if ((ITSTATE_FOR_SYNTAX & 0b00010000) == 0b00010000)	//firstcondition bit check
-		{
-			switch (ITSTATE_FOR_SYNTAX & 0b00001111)
-			{
-				case 0b1100: ITBLOCK_FOR_SYNTAX = 0b10000000; break;
-				case 0b0100: ITBLOCK_FOR_SYNTAX = 0b01000000; break;
-				case 0b1110: ITBLOCK_FOR_SYNTAX = 0b10100000; break;
-				case 0b0110: ITBLOCK_FOR_SYNTAX = 0b01100000; break;
-				case 0b1010: ITBLOCK_FOR_SYNTAX = 0b10010000; break;
-				case 0b0010: ITBLOCK_FOR_SYNTAX = 0b01010000; break;
-				case 0b1111: ITBLOCK_FOR_SYNTAX = 0b10101000; break;
-				case 0b0111: ITBLOCK_FOR_SYNTAX = 0b01101000; break;
-				case 0b1011: ITBLOCK_FOR_SYNTAX = 0b10011000; break;
-				case 0b0011: ITBLOCK_FOR_SYNTAX = 0b01011000; break;
-				case 0b1101: ITBLOCK_FOR_SYNTAX = 0b10100100; break;
-				case 0b0101: ITBLOCK_FOR_SYNTAX = 0b01100100; break;
-				case 0b1001: ITBLOCK_FOR_SYNTAX = 0b10010100; break;
-				case 0b0001: ITBLOCK_FOR_SYNTAX = 0b01010100; break;
-				default:  ITBLOCK_FOR_SYNTAX = 0b00000000;  break;
-			}
-		}
-		else
-		{
-			switch (ITSTATE_FOR_SYNTAX & 0b00001111)
-			{
-				case 0b0100: ITBLOCK_FOR_SYNTAX = 0b10000000; break;
-				case 0b1100: ITBLOCK_FOR_SYNTAX = 0b01000000; break;
-				case 0b0010: ITBLOCK_FOR_SYNTAX = 0b10100000; break;
-				case 0b1010: ITBLOCK_FOR_SYNTAX = 0b01100000; break;
-				case 0b0110: ITBLOCK_FOR_SYNTAX = 0b10010000; break;
-				case 0b1110: ITBLOCK_FOR_SYNTAX = 0b01010000; break;
-				case 0b0001: ITBLOCK_FOR_SYNTAX = 0b10101000; break;
-				case 0b1001: ITBLOCK_FOR_SYNTAX = 0b01101000; break;
-				case 0b0101: ITBLOCK_FOR_SYNTAX = 0b10011000; break;
-				case 0b1101: ITBLOCK_FOR_SYNTAX = 0b01011000; break;
-				case 0b0011: ITBLOCK_FOR_SYNTAX = 0b10100100; break;
-				case 0b1011: ITBLOCK_FOR_SYNTAX = 0b01100100; break;
-				case 0b0111: ITBLOCK_FOR_SYNTAX = 0b10010100; break;
-				case 0b1111: ITBLOCK_FOR_SYNTAX = 0b01010100; break;
-				default: ITBLOCK_FOR_SYNTAX = 0b00000000; break;
-			}
-		}
-	}
-}
-
-
 uint8_t f_set_ITSTATE(uint8_t value)
 {
-    ITSTATE_FOR_SYNTAX = value;
-	ITBLOCK_BASE_CONDITION_FOR_SYNTAX = value >> 4; // condition
-	f_calc_condition_ITSTATE();
+	ITSTATE_FOR_SYNTAX = value;
 	return value;
 }
 
@@ -28,7 +28,6 @@ extern "C" {
 uint8_t f_get_ITSTATE(void);
 uint8_t f_set_ITSTATE(uint8_t value);
 uint8_t f_get_update_ITSTATE(void);
-void f_calc_condition_ITSTATE(void);
 
 uint8_t f_get_C(void);
 
@@ -0,0 +1,171 @@
+/*!
+ * Per-instruction execution counters
+ *
+ * \file stats.c
+ *
+ * Counters are 64-bit and indexed by instruction identifier, so the probe
+ * costs one load and one increment. Nothing is computed for groups at
+ * run-time: they are summed up when the counters are dumped.
+ *
+ * If the environment variable ARM_STATS_OUT is set when the state is
+ * created, the counters are dumped to the named file when the state is
+ * destroyed (JSON if the name ends with ".json", CSV else). This gives
+ * access to the statistics from the generated simulator.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/id.h>
+#include <gliss/stats.h>
+
+#define MAX_GROUPS	64
+
+typedef struct group_t {
+	const char *name;
+	uint64_t cnt;
+} group_t;
+
+
+/**
+ * Allocate the counters of a new state.
+ * @param state		Initialized state.
+ */
+void gliss_stats_init(gliss_state_t *state) {
+	state->stats_cnt = (uint64_t *)calloc(GLISS_TOP, sizeof(uint64_t));
+	if(state->stats_cnt == NULL) {
+		fprintf(stderr, "ERROR: cannot allocate instruction counters\n");
+		abort();
+	}
+}
+
+
+/**
+ * Release the counters of a state, dumping them before if required
+ * by ARM_STATS_OUT.
+ * @param state		Destroyed state.
+ */
+void gliss_stats_destroy(gliss_state_t *state) {
+	const char *path = getenv("ARM_STATS_OUT");
+	if(path != NULL && gliss_stats_dump(state, path) != 0)
+		fprintf(stderr, "ERROR: cannot dump statistics to %s\n", path);
+	free(state->stats_cnt);
+	state->stats_cnt = NULL;
+}
+
+
+/**
+ * Reset all counters to 0.
+ * @param state		State to reset counters for.
+ */
+void gliss_stats_reset(gliss_state_t *state) {
+	memset(state->stats_cnt, 0, GLISS_TOP * sizeof(uint64_t));
+}
+
+
+/**
+ * Get the execution count of an instruction.
+ * @param state		Current state.
+ * @param id		Instruction identifier (GLISS_XXX).
+ * @return			Execution count.
+ */
+uint64_t gliss_stats_count(gliss_state_t *state, int id) {
+	if(id < 0 || id >= GLISS_TOP)
+		return 0;
+	return state->stats_cnt[id];
+}
+
+
+/**
+ * Sum up the counters by group.
+ * @param state		Current state.
+ * @param groups	Array of MAX_GROUPS groups to fill.
+ * @return			Number of found groups.
+ */
+static int sum_groups(gliss_state_t *state, group_t *groups) {
+	int i, j, n = 0;
+	for(i = 0; i < GLISS_TOP; i++) {
+		if(state->stats_cnt[i] == 0)
+			continue;
+		for(j = 0; j < n; j++)
+			if(strcmp(groups[j].name, gliss_stats_info[i].group) == 0)
+				break;
+		if(j == n) {
+			if(n == MAX_GROUPS)
+				continue;
+			groups[n].name = gliss_stats_info[i].group;
+			groups[n].cnt = 0;
+			n++;
+		}
+		groups[j].cnt += state->stats_cnt[i];
+	}
+	return n;
+}
+
+
+/**
+ * Dump the counters as CSV: one line "name,group,count" by executed
+ * instruction followed by lines "*,group,count" for the groups.
+ * @param state		Current state.
+ * @param out		Stream to output to.
+ */
+void gliss_stats_dump_csv(gliss_state_t *state, FILE *out) {
+	group_t groups[MAX_GROUPS];
+	int i, n;
+
+	fprintf(out, "name,group,count\n");
+	for(i = 0; i < GLISS_TOP; i++)
+		if(state->stats_cnt[i] != 0)
+			fprintf(out, "%s,%s,%llu\n", gliss_stats_info[i].name,
+				gliss_stats_info[i].group, (unsigned long long)state->stats_cnt[i]);
+	n = sum_groups(state, groups);
+	for(i = 0; i < n; i++)
+		fprintf(out, "*,%s,%llu\n", groups[i].name, (unsigned long long)groups[i].cnt);
+}
+
+
+/**
+ * Dump the counters as a JSON object with members "instructions"
+ * and "groups".
+ * @param state		Current state.
+ * @param out		Stream to output to.
+ */
+void gliss_stats_dump_json(gliss_state_t *state, FILE *out) {
+	group_t groups[MAX_GROUPS];
+	int i, n, first = 1;
+
+	fprintf(out, "{\n\t\"instructions\": [");
+	for(i = 0; i < GLISS_TOP; i++)
+		if(state->stats_cnt[i] != 0) {
+			fprintf(out, "%s\n\t\t{ \"name\": \"%s\", \"group\": \"%s\", \"count\": %llu }",
+				first ? "" : ",", gliss_stats_info[i].name, gliss_stats_info[i].group,
+				(unsigned long long)state->stats_cnt[i]);
+			first = 0;
+		}
+	fprintf(out, "\n\t],\n\t\"groups\": {");
+	n = sum_groups(state, groups);
+	for(i = 0; i < n; i++)
+		fprintf(out, "%s\n\t\t\"%s\": %llu", i == 0 ? "" : ",",
+			groups[i].name, (unsigned long long)groups[i].cnt);
+	fprintf(out, "\n\t}\n}\n");
+}
+
+
+/**
+ * Dump the counters to a file, as JSON if the path ends with ".json",
+ * as CSV else.
+ * @param state		Current state.
+ * @param path		Path of the file.
+ * @return			0 for success, -1 else (errno is set).
+ */
+int gliss_stats_dump(gliss_state_t *state, const char *path) {
+	size_t l = strlen(path);
+	FILE *out = fopen(path, "w");
+	if(out == NULL)
+		return -1;
+	if(l >= 5 && strcmp(path + l - 5, ".json") == 0)
+		gliss_stats_dump_json(state, out);
+	else
+		gliss_stats_dump_csv(state, out);
+	return fclose(out);
+}
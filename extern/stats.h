@@ -0,0 +1,49 @@
+/*!
+ * Per-instruction execution counters
+ *
+ * \file stats.h
+ *
+ * Only linked when WITH_STATS is configured: the instruction probe
+ * (nmp/probe-on.nmp) then increments one counter per instruction
+ * identifier in the state. Names and groups of the identifiers come
+ * from src/stats_info.c, generated by gliss-attr from nmp/stats.nmp.
+ */
+
+#ifndef GLISS_STATS_H
+#define GLISS_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+
+#define GLISS_STATS_STATE		uint64_t *stats_cnt;
+#define GLISS_STATS_INIT(s)		gliss_stats_init(s)
+#define GLISS_STATS_DESTROY(s)	gliss_stats_destroy(s)
+
+/* instruction probe: s is the state, i the instruction */
+#define gliss_stats_inst(s, i)	((s)->stats_cnt[(i)->ident]++)
+
+typedef struct gliss_stats_info_t {
+	const char *name;
+	const char *group;
+} gliss_stats_info_t;
+extern gliss_stats_info_t gliss_stats_info[];
+
+void gliss_stats_init(struct gliss_state_t *state);
+void gliss_stats_destroy(struct gliss_state_t *state);
+void gliss_stats_reset(struct gliss_state_t *state);
+uint64_t gliss_stats_count(struct gliss_state_t *state, int id);
+void gliss_stats_dump_csv(struct gliss_state_t *state, FILE *out);
+void gliss_stats_dump_json(struct gliss_state_t *state, FILE *out);
+int gliss_stats_dump(struct gliss_state_t *state, const char *path);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_STATS_H */
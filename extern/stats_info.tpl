@@ -0,0 +1,9 @@
+/* Generated by gliss-attr ($(date)) from nmp/stats.nmp -- do not edit */
+#include <arm/api.h>
+#include <arm/id.h>
+#include <arm/stats.h>
+
+arm_stats_info_t arm_stats_info[] = {
+	{ "UNKNOWN", "other" }$(foreach instructions),
+	{ "$(ident)", $(stat_group) }$(end)
+};
@@ -0,0 +1,40 @@
+/*!
+ * Packed (SIMD within a register) helpers for the ARMv6/v7 parallel
+ * add/subtract instructions.
+ *
+ * \file swar.c
+ *
+ * The plain add and subtract kernels are inlined from swar.h. The
+ * exchanging forms (ASX, SAX), less frequent, are built here from a
+ * halfword add and a halfword subtract on the swapped second operand.
+ */
+
+#include <gliss/api.h>
+#include <gliss/swar.h>
+
+/**
+ * Parallel add and subtract with exchange.
+ * For ASX, the result is (a.hi + b.lo) :: (a.lo - b.hi);
+ * for SAX, the result is (a.hi - b.lo) :: (a.lo + b.hi).
+ * @param k		Kind of operation (one of GLISS_SWAR_xxx).
+ * @param asx	Not null for ASX, null for SAX.
+ * @param a		First operand.
+ * @param b		Second operand.
+ * @param ge	Receives the GE bits for GLISS_SWAR_S and GLISS_SWAR_U.
+ * @return		Packed result.
+ */
+uint32_t gliss_swar_exchange(int k, int asx, uint32_t a, uint32_t b, uint32_t *ge) {
+	uint32_t x = (b >> 16) | (b << 16), s, d, sg = 0, dg = 0;
+	s = gliss_swar_add(k, 16, a, x, &sg);
+	d = gliss_swar_sub(k, 16, a, x, &dg);
+	if(asx) {
+		if(k == GLISS_SWAR_S || k == GLISS_SWAR_U)
+			*ge = (sg & 0xc) | (dg & 0x3);
+		return (s & 0xffff0000) | (d & 0x0000ffff);
+	}
+	else {
+		if(k == GLISS_SWAR_S || k == GLISS_SWAR_U)
+			*ge = (dg & 0xc) | (sg & 0x3);
+		return (d & 0xffff0000) | (s & 0x0000ffff);
+	}
+}
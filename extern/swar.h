@@ -0,0 +1,202 @@
+/*!
+ * Packed (SIMD within a register) helpers for the ARMv6/v7 parallel
+ * add/subtract instructions.
+ *
+ * \file swar.h
+ *
+ * The parallel instructions (SADD8, QSUB16, UHASX, SEL, ...) work on four
+ * bytes or two halfwords packed in a 32-bit register. Instead of extracting
+ * each lane, the kernels below work on the whole word: carries are stopped
+ * at lane boundaries by masking the lane top bits and the GE bits are built
+ * from a mask of the lane top bits (carry, borrow or sign).
+ *
+ * The kind (GLISS_SWAR_S, ...) and lane width are constant at each call site
+ * so that, once inlined, each instruction reduces to a few host operations.
+ * The saturating kinds use the SSE2 saturating additions when available.
+ * As a function may only return one value, the GE bits of the last
+ * signed/unsigned (modulo) operation are left in the state and read back
+ * with gliss_swar_ge().
+ */
+
+#ifndef GLISS_SWAR_H
+#define GLISS_SWAR_H
+
+#include <stdint.h>
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define GLISS_SWAR_STATE		uint32_t swar_ge;
+#define GLISS_SWAR_INIT(s)		(s)->swar_ge = 0
+#define GLISS_SWAR_DESTROY(s)
+
+/* operation kinds (prefix of the instruction) */
+#define GLISS_SWAR_S	0		/* signed, modulo, GE set */
+#define GLISS_SWAR_Q	1		/* signed saturating */
+#define GLISS_SWAR_SH	2		/* signed halving */
+#define GLISS_SWAR_U	3		/* unsigned, modulo, GE set */
+#define GLISS_SWAR_UQ	4		/* unsigned saturating */
+#define GLISS_SWAR_UH	5		/* unsigned halving */
+
+/* lane top bits */
+#define GLISS_SWAR_H8	0x80808080U
+#define GLISS_SWAR_H16	0x80008000U
+
+static inline uint32_t gliss_swar_high(int w) {
+	return w == 8 ? GLISS_SWAR_H8 : GLISS_SWAR_H16;
+}
+
+/* lane-wise modulo add and subtract */
+static inline uint32_t gliss_swar_padd(uint32_t a, uint32_t b, uint32_t h) {
+	return ((a & ~h) + (b & ~h)) ^ ((a ^ b) & h);
+}
+
+static inline uint32_t gliss_swar_psub(uint32_t a, uint32_t b, uint32_t h) {
+	return ((a | h) - (b & ~h)) ^ ((a ^ ~b) & h);
+}
+
+/* spread the top bit of each lane to the whole lane */
+static inline uint32_t gliss_swar_spread(uint32_t x, int w) {
+	return ((x & gliss_swar_high(w)) >> (w - 1)) * (w == 8 ? 0xffU : 0xffffU);
+}
+
+/* gather the top bit of each lane as GE bits (halfword lanes set two GE bits) */
+static inline uint32_t gliss_swar_gather(uint32_t x, int w) {
+	if(w == 8)
+		return ((((x >> 7) & 0x01010101U) * 0x01020408U) >> 24) & 0xf;
+	else
+		return ((x >> 15) & 1) * 0x3 | (x >> 31) * 0xc;
+}
+
+/* unsigned halving add and subtract (floor of the exact result) */
+static inline uint32_t gliss_swar_uhadd(uint32_t a, uint32_t b, uint32_t h) {
+	return (a & b) + (((a ^ b) >> 1) & ~h);
+}
+
+static inline uint32_t gliss_swar_uhsub(uint32_t a, uint32_t b, uint32_t h) {
+	return gliss_swar_psub(((a ^ b) >> 1) & ~h, ~a & b, h);
+}
+
+#ifdef __SSE2__
+#	define GLISS_SWAR_SSE(f, a, b)	((uint32_t)_mm_cvtsi128_si32(f(_mm_cvtsi32_si128((int)(a)), _mm_cvtsi32_si128((int)(b)))))
+#endif
+
+/**
+ * Parallel add of a and b.
+ * @param k		Kind of operation (one of GLISS_SWAR_xxx).
+ * @param w		Lane width (8 or 16).
+ * @param a		First operand.
+ * @param b		Second operand.
+ * @param ge	Receives the GE bits for GLISS_SWAR_S and GLISS_SWAR_U.
+ * @return		Packed result.
+ */
+static inline uint32_t gliss_swar_add(int k, int w, uint32_t a, uint32_t b, uint32_t *ge) {
+	uint32_t h = gliss_swar_high(w), r, o;
+#	ifndef __SSE2__
+		uint32_t m;
+#	endif
+	switch(k) {
+	case GLISS_SWAR_S:
+		r = gliss_swar_padd(a, b, h);
+		o = ~(a ^ b) & (a ^ r);
+		*ge = gliss_swar_gather(~(r ^ o), w);
+		return r;
+	case GLISS_SWAR_Q:
+#		ifdef __SSE2__
+			return w == 8 ? GLISS_SWAR_SSE(_mm_adds_epi8, a, b) : GLISS_SWAR_SSE(_mm_adds_epi16, a, b);
+#		else
+			r = gliss_swar_padd(a, b, h);
+			m = gliss_swar_spread(~(a ^ b) & (a ^ r), w);
+			return (r & ~m) | ((~h ^ gliss_swar_spread(a, w)) & m);
+#		endif
+	case GLISS_SWAR_SH:
+		return gliss_swar_uhadd(a ^ h, b ^ h, h) ^ h;
+	case GLISS_SWAR_U:
+		r = gliss_swar_padd(a, b, h);
+		*ge = gliss_swar_gather((a & b) | ((a | b) & ~r), w);
+		return r;
+	case GLISS_SWAR_UQ:
+#		ifdef __SSE2__
+			return w == 8 ? GLISS_SWAR_SSE(_mm_adds_epu8, a, b) : GLISS_SWAR_SSE(_mm_adds_epu16, a, b);
+#		else
+			r = gliss_swar_padd(a, b, h);
+			return r | gliss_swar_spread((a & b) | ((a | b) & ~r), w);
+#		endif
+	default:
+		return gliss_swar_uhadd(a, b, h);
+	}
+}
+
+/**
+ * Parallel subtract of b from a (see gliss_swar_add() for the parameters).
+ */
+static inline uint32_t gliss_swar_sub(int k, int w, uint32_t a, uint32_t b, uint32_t *ge) {
+	uint32_t h = gliss_swar_high(w), r, o;
+#	ifndef __SSE2__
+		uint32_t m;
+#	endif
+	switch(k) {
+	case GLISS_SWAR_S:
+		r = gliss_swar_psub(a, b, h);
+		o = (a ^ b) & (a ^ r);
+		*ge = gliss_swar_gather(~(r ^ o), w);
+		return r;
+	case GLISS_SWAR_Q:
+#		ifdef __SSE2__
+			return w == 8 ? GLISS_SWAR_SSE(_mm_subs_epi8, a, b) : GLISS_SWAR_SSE(_mm_subs_epi16, a, b);
+#		else
+			r = gliss_swar_psub(a, b, h);
+			m = gliss_swar_spread((a ^ b) & (a ^ r), w);
+			return (r & ~m) | ((~h ^ gliss_swar_spread(a, w)) & m);
+#		endif
+	case GLISS_SWAR_SH:
+		return gliss_swar_uhsub(a ^ h, b ^ h, h);
+	case GLISS_SWAR_U:
+		r = gliss_swar_psub(a, b, h);
+		*ge = gliss_swar_gather(~((~a & b) | (~(a ^ b) & r)), w);
+		return r;
+	case GLISS_SWAR_UQ:
+#		ifdef __SSE2__
+			return w == 8 ? GLISS_SWAR_SSE(_mm_subs_epu8, a, b) : GLISS_SWAR_SSE(_mm_subs_epu16, a, b);
+#		else
+			r = gliss_swar_psub(a, b, h);
+			return r & ~gliss_swar_spread((~a & b) | (~(a ^ b) & r), w);
+#		endif
+	default:
+		return gliss_swar_uhsub(a, b, h);
+	}
+}
+
+/**
+ * Select bytes of a (GE bit set) or of b (GE bit clear), as SEL.
+ * @param ge	GE bits.
+ * @param a		First operand.
+ * @param b		Second operand.
+ * @return		Selected bytes.
+ */
+static inline uint32_t gliss_swar_select(uint32_t ge, uint32_t a, uint32_t b) {
+	uint32_t m = ((ge * 0x00204081U) & 0x01010101U) * 0xff;
+	return (a & m) | (b & ~m);
+}
+
+uint32_t gliss_swar_exchange(int k, int asx, uint32_t a, uint32_t b, uint32_t *ge);
+
+/* accessors used by the execution code (state is in scope) */
+#define gliss_swar_add8(k, a, b)	gliss_swar_add((k), 8, (a), (b), &state->swar_ge)
+#define gliss_swar_add16(k, a, b)	gliss_swar_add((k), 16, (a), (b), &state->swar_ge)
+#define gliss_swar_sub8(k, a, b)	gliss_swar_sub((k), 8, (a), (b), &state->swar_ge)
+#define gliss_swar_sub16(k, a, b)	gliss_swar_sub((k), 16, (a), (b), &state->swar_ge)
+#define gliss_swar_asx(k, a, b)		gliss_swar_exchange((k), 1, (a), (b), &state->swar_ge)
+#define gliss_swar_sax(k, a, b)		gliss_swar_exchange((k), 0, (a), (b), &state->swar_ge)
+#define gliss_swar_sel(g, a, b)		gliss_swar_select((g), (a), (b))
+#define gliss_swar_ge()				(state->swar_ge)
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_SWAR_H */
@@ -1,6 +1,662 @@
+/*!
+ * Host system calls
+ *
+ * \file sys_call.c
+ *
+ * The guest file descriptors index a table of host streams: 0, 1 and 2 are
+ * bound to the simulator standard streams and the other entries are opened
+ * on demand. Both conventions (semihosting and EABI) share the same table
+ * as a guest only uses one of them. Transfers go through a 64 KiB bounce
+ * buffer between the guest memory and the host stream so that a 100 MB
+ * read or write only costs a few thousands of copies. The guest memory
+ * accesses of a call are hidden from the memory spies (cache, trace).
+ *
+ * The heap of EABI guests (brk) starts at ARM_HEAP_BASE (hexadecimal or
+ * decimal) when this environment variable is set, at GLISS_SYS_HEAP else.
+ * Semihosting guests (SYS_HEAPINFO) are only given a heap when ARM_HEAP_BASE
+ * is set and use the end of their image else.
+ *
+ * When the guest exits, the streams are flushed, the state is deleted (so
+ * that the other modules output their results) and the simulator exits with
+ * the guest exit code.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <gliss/api.h>
+#include <gliss/mem.h>
 #include <gliss/sys_call.h>
 
-void swi_impl(int code)
-{
-	/* no system calls for the moment */
+#define FILE_MAX		64
+#define BUF_SIZE		(64 * 1024)
+#define PATH_SIZE		4096
+#define GLISS_SYS_HEAP	0x60000000
+#define HEAP_SIZE		(64 * 1024 * 1024)
+
+/* last operation on a stream (C streams require a seek between both) */
+#define LAST_NONE		0
+#define LAST_READ		1
+#define LAST_WRITE		2
+
+/* semihosting operations */
+#define SYS_OPEN			0x01
+#define SYS_CLOSE			0x02
+#define SYS_WRITEC			0x03
+#define SYS_WRITE0			0x04
+#define SYS_WRITE			0x05
+#define SYS_READ			0x06
+#define SYS_READC			0x07
+#define SYS_ISERROR			0x08
+#define SYS_ISTTY			0x09
+#define SYS_SEEK			0x0a
+#define SYS_FLEN			0x0c
+#define SYS_REMOVE			0x0e
+#define SYS_RENAME			0x0f
+#define SYS_CLOCK			0x10
+#define SYS_TIME			0x11
+#define SYS_ERRNO			0x13
+#define SYS_GET_CMDLINE		0x15
+#define SYS_HEAPINFO		0x16
+#define SYS_EXIT			0x18
+#define SYS_EXIT_EXTENDED	0x20
+#define ADP_APPLICATION_EXIT	0x20026
+
+/* Linux EABI system calls */
+#define NR_EXIT				1
+#define NR_READ				3
+#define NR_WRITE			4
+#define NR_OPEN				5
+#define NR_CLOSE			6
+#define NR_LSEEK			19
+#define NR_TIMES			43
+#define NR_BRK				45
+#define NR_GETTIMEOFDAY		78
+#define NR_EXIT_GROUP		248
+#define NR_CLOCK_GETTIME	263
+
+/* Linux ARM open flags */
+#define LX_O_ACCMODE	0x003
+#define LX_O_CREAT		0x040
+#define LX_O_EXCL		0x080
+#define LX_O_TRUNC		0x200
+#define LX_O_APPEND		0x400
+
+typedef struct file_t {
+	FILE *f;
+	int last;
+} file_t;
+
+typedef struct gliss_sys_t {
+	file_t files[FILE_MAX];
+	int err;
+	uint32_t heap;
+	uint32_t brk;
+	struct timespec start;
+	char buf[BUF_SIZE];
+} gliss_sys_t;
+
+
+/**
+ * Initialize the system call layer of a state.
+ * @param state		Initialized state.
+ */
+void gliss_sys_call_init(gliss_state_t *state) {
+	const char *heap = getenv("ARM_HEAP_BASE");
+	gliss_sys_t *sys = (gliss_sys_t *)calloc(1, sizeof(gliss_sys_t));
+	state->sys = sys;
+	state->spy_quiet = 0;
+	if(sys == NULL) {
+		fprintf(stderr, "ERROR: no more memory for system calls\n");
+		return;
+	}
+	sys->files[0].f = stdin;
+	sys->files[1].f = stdout;
+	sys->files[2].f = stderr;
+	if(heap != NULL)
+		sys->heap = strtoul(heap, NULL, 0);
+	sys->brk = sys->heap != 0 ? sys->heap : GLISS_SYS_HEAP;
+	clock_gettime(CLOCK_MONOTONIC, &sys->start);
+}
+
+
+/**
+ * Flush the guest streams.
+ * @param state		Current state.
+ */
+void gliss_sys_call_flush(gliss_state_t *state) {
+	int i;
+	if(state->sys == NULL)
+		return;
+	for(i = 0; i < FILE_MAX; i++)
+		if(state->sys->files[i].f != NULL)
+			fflush(state->sys->files[i].f);
+}
+
+
+/**
+ * Close the files opened by the guest and release the system call layer.
+ * @param state		Current state.
+ */
+void gliss_sys_call_destroy(gliss_state_t *state) {
+	int i;
+	if(state->sys == NULL)
+		return;
+	gliss_sys_call_flush(state);
+	for(i = 0; i < FILE_MAX; i++) {
+		FILE *f = state->sys->files[i].f;
+		if(f != NULL && f != stdin && f != stdout && f != stderr)
+			fclose(f);
+	}
+	free(state->sys);
+	state->sys = NULL;
+}
+
+
+/**
+ * Flush everything and exit the simulator.
+ * @param state		Current state.
+ * @param code		Exit code of the guest.
+ */
+static void sys_exit(gliss_state_t *state, int code) {
+	gliss_sys_call_flush(state);
+	gliss_delete_state(state);
+	fflush(NULL);
+	exit(code);
+}
+
+
+/**
+ * Get the stream of a guest file descriptor.
+ * @param sys	System call layer.
+ * @param fd	Guest file descriptor.
+ * @param last	Next operation (LAST_READ or LAST_WRITE).
+ * @return		Matching stream or NULL (errno set).
+ */
+static FILE *sys_file(gliss_sys_t *sys, uint32_t fd, int last) {
+	file_t *file;
+	if(fd >= FILE_MAX || sys->files[fd].f == NULL) {
+		sys->err = EBADF;
+		return NULL;
+	}
+	file = &sys->files[fd];
+	if(file->last != last && file->last != LAST_NONE)
+		fseeko(file->f, 0, SEEK_CUR);
+	file->last = last;
+	return file->f;
+}
+
+
+/**
+ * Record a new host stream in the table.
+ * @param sys	System call layer.
+ * @param f		Host stream (may be NULL on error).
+ * @return		Guest file descriptor or -1 (errno set).
+ */
+static int32_t sys_add(gliss_sys_t *sys, FILE *f) {
+	int i;
+	if(f == NULL) {
+		sys->err = errno;
+		return -1;
+	}
+	for(i = 3; i < FILE_MAX; i++)
+		if(sys->files[i].f == NULL) {
+			if(f != stdin && f != stdout && f != stderr)
+				setvbuf(f, NULL, _IOFBF, BUF_SIZE);
+			sys->files[i].f = f;
+			sys->files[i].last = LAST_NONE;
+			return i;
+		}
+	if(f != stdin && f != stdout && f != stderr)
+		fclose(f);
+	sys->err = EMFILE;
+	return -1;
+}
+
+
+/**
+ * Close a guest file descriptor (the standard streams are only detached).
+ * @param sys	System call layer.
+ * @param fd	Guest file descriptor.
+ * @return		0 for success, -1 else (errno set).
+ */
+static int32_t sys_close(gliss_sys_t *sys, uint32_t fd) {
+	FILE *f;
+	if(fd >= FILE_MAX || sys->files[fd].f == NULL) {
+		sys->err = EBADF;
+		return -1;
+	}
+	f = sys->files[fd].f;
+	sys->files[fd].f = NULL;
+	if(f == stdin || f == stdout || f == stderr)
+		return fflush(f) == 0 ? 0 : -1;
+	if(fclose(f) != 0) {
+		sys->err = errno;
+		return -1;
+	}
+	return 0;
+}
+
+
+/**
+ * Write guest memory to a guest file descriptor.
+ * @param state		Current state.
+ * @param fd		Guest file descriptor.
+ * @param addr		Guest buffer address.
+ * @param size		Size to write.
+ * @return			Written size or -1 (errno set).
+ */
+static int32_t sys_write(gliss_state_t *state, uint32_t fd, uint32_t addr, uint32_t size) {
+	gliss_sys_t *sys = state->sys;
+	FILE *f = sys_file(sys, fd, LAST_WRITE);
+	uint32_t done = 0;
+	if(f == NULL)
+		return -1;
+	while(done < size) {
+		size_t n = size - done < BUF_SIZE ? size - done : BUF_SIZE, w;
+		gliss_mem_read(state->M, addr + done, sys->buf, n);
+		w = fwrite(sys->buf, 1, n, f);
+		done += w;
+		if(w < n) {
+			sys->err = errno;
+			return done == 0 ? -1 : (int32_t)done;
+		}
+	}
+	if(f == stderr)
+		fflush(f);
+	return done;
+}
+
+
+/**
+ * Read a guest file descriptor to guest memory. Terminals are read up to the
+ * end of line to not block the guest.
+ * @param state		Current state.
+ * @param fd		Guest file descriptor.
+ * @param addr		Guest buffer address.
+ * @param size		Size to read.
+ * @return			Read size or -1 (errno set).
+ */
+static int32_t sys_read(gliss_state_t *state, uint32_t fd, uint32_t addr, uint32_t size) {
+	gliss_sys_t *sys = state->sys;
+	FILE *f = sys_file(sys, fd, LAST_READ);
+	uint32_t done = 0;
+	if(f == NULL)
+		return -1;
+	if(isatty(fileno(f))) {
+		int c = 0;
+		fflush(stdout);
+		while(done < size && c != '\n' && (c = getc(f)) != EOF)
+			gliss_mem_write8(state->M, addr + done++, c);
+		return done;
+	}
+	while(done < size) {
+		size_t n = size - done < BUF_SIZE ? size - done : BUF_SIZE, r;
+		r = fread(sys->buf, 1, n, f);
+		gliss_mem_write(state->M, addr + done, sys->buf, r);
+		done += r;
+		if(r < n) {
+			if(ferror(f)) {
+				sys->err = errno;
+				return done == 0 ? -1 : (int32_t)done;
+			}
+			break;
+		}
+	}
+	return done;
+}
+
+
+/**
+ * Read a file name from guest memory.
+ * @param state		Current state.
+ * @param addr		Guest address of the name.
+ * @param len		Name length or -1 for a null-terminated name.
+ * @param buf		Buffer of PATH_SIZE bytes.
+ * @return			buf or NULL if the name is too long.
+ */
+static char *sys_name(gliss_state_t *state, uint32_t addr, int32_t len, char *buf) {
+	int32_t i;
+	for(i = 0; i < PATH_SIZE; i++) {
+		if(i == len)
+			break;
+		buf[i] = gliss_mem_read8(state->M, addr + i);
+		if(buf[i] == '\0' && len < 0)
+			return buf;
+	}
+	if(i == PATH_SIZE) {
+		state->sys->err = ENAMETOOLONG;
+		return NULL;
+	}
+	buf[i] = '\0';
+	return buf;
+}
+
+
+/**
+ * Perform a semihosting call: operation in r0, parameter in r1, result in r0.
+ * @param state		Current state.
+ */
+void gliss_sys_call_semihost(gliss_state_t *state) {
+	static const char *modes[] = { "r", "rb", "r+", "r+b", "w", "wb", "w+", "w+b", "a", "ab", "a+", "a+b" };
+	gliss_sys_t *sys = state->sys;
+	uint32_t p = state->GPR[1], a[4];
+	int32_t r = -1;
+	char name[PATH_SIZE], to[PATH_SIZE];
+	FILE *f;
+	int i;
+
+	gliss_spy_suspend(state);
+
+	/* most operations take a parameter block */
+	switch(state->GPR[0]) {
+	case SYS_WRITEC: case SYS_WRITE0: case SYS_READC: case SYS_CLOCK:
+	case SYS_TIME: case SYS_ERRNO: case SYS_EXIT:
+		break;
+	default:
+		for(i = 0; i < 4; i++)
+			a[i] = gliss_mem_read32(state->M, p + i * 4);
+		break;
+	}
+
+	switch(state->GPR[0]) {
+	case SYS_OPEN:
+		if(a[1] >= 12 || sys_name(state, a[0], a[2], name) == NULL)
+			break;
+		if(strcmp(name, ":tt") == 0)
+			r = sys_add(sys, a[1] < 4 ? stdin : (a[1] < 8 ? stdout : stderr));
+		else
+			r = sys_add(sys, fopen(name, modes[a[1]]));
+		break;
+	case SYS_CLOSE:
+		r = sys_close(sys, a[0]);
+		break;
+	case SYS_WRITEC:
+		putchar(gliss_mem_read8(state->M, p));
+		r = state->GPR[0];
+		break;
+	case SYS_WRITE0:
+		for(i = gliss_mem_read8(state->M, p); i != 0; i = gliss_mem_read8(state->M, ++p))
+			putchar(i);
+		r = state->GPR[0];
+		break;
+	case SYS_WRITE:
+		r = sys_write(state, a[0], a[1], a[2]);
+		r = r < 0 ? (int32_t)a[2] : (int32_t)a[2] - r;
+		break;
+	case SYS_READ:
+		r = sys_read(state, a[0], a[1], a[2]);
+		r = r < 0 ? (int32_t)a[2] : (int32_t)a[2] - r;
+		break;
+	case SYS_READC:
+		fflush(stdout);
+		r = getchar();
+		break;
+	case SYS_ISERROR:
+		r = (int32_t)a[0] < 0;
+		break;
+	case SYS_ISTTY:
+		f = a[0] < FILE_MAX ? sys->files[a[0]].f : NULL;
+		r = f != NULL && isatty(fileno(f));
+		break;
+	case SYS_SEEK:
+		f = sys_file(sys, a[0], LAST_NONE);
+		if(f != NULL && fseeko(f, a[1], SEEK_SET) == 0)
+			r = 0;
+		else if(f != NULL)
+			sys->err = errno;
+		break;
+	case SYS_FLEN:
+		f = a[0] < FILE_MAX ? sys->files[a[0]].f : NULL;
+		if(f != NULL) {
+			off_t pos = ftello(f);
+			if(fseeko(f, 0, SEEK_END) == 0) {
+				r = ftello(f);
+				fseeko(f, pos, SEEK_SET);
+			}
+		}
+		break;
+	case SYS_REMOVE:
+		if(sys_name(state, a[0], a[1], name) != NULL && (r = remove(name)) != 0)
+			sys->err = errno;
+		break;
+	case SYS_RENAME:
+		if(sys_name(state, a[0], a[1], name) != NULL && sys_name(state, a[2], a[3], to) != NULL
+		&& (r = rename(name, to)) != 0)
+			sys->err = errno;
+		break;
+	case SYS_CLOCK: {
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			r = (now.tv_sec - sys->start.tv_sec) * 100 + (now.tv_nsec - sys->start.tv_nsec) / 10000000;
+		}
+		break;
+	case SYS_TIME:
+		r = time(NULL);
+		break;
+	case SYS_ERRNO:
+		r = sys->err;
+		break;
+	case SYS_GET_CMDLINE:
+		if(a[1] > 0) {
+			gliss_mem_write8(state->M, a[0], 0);
+			gliss_mem_write32(state->M, p + 4, 0);
+			r = 0;
+		}
+		break;
+	case SYS_HEAPINFO:
+		p = a[0];
+		gliss_mem_write32(state->M, p, sys->heap);
+		gliss_mem_write32(state->M, p + 4, sys->heap != 0 ? sys->heap + HEAP_SIZE : 0);
+		gliss_mem_write32(state->M, p + 8, 0);
+		gliss_mem_write32(state->M, p + 12, 0);
+		r = 0;
+		break;
+	case SYS_EXIT:
+		sys_exit(state, state->GPR[1] == ADP_APPLICATION_EXIT ? 0 : 1);
+		break;
+	case SYS_EXIT_EXTENDED:
+		sys_exit(state, a[0] == ADP_APPLICATION_EXIT ? (int)a[1] : 1);
+		break;
+	default:
+		sys->err = ENOSYS;
+		break;
+	}
+	state->GPR[0] = r;
+	gliss_spy_resume(state);
+}
+
+
+/**
+ * Translate Linux ARM open flags to a host stream.
+ * @param name	File name.
+ * @param flags	Linux ARM flags.
+ * @param mode	Creation mode.
+ * @return		Opened stream or NULL (errno set).
+ */
+static FILE *sys_open(const char *name, uint32_t flags, uint32_t mode) {
+	int hf = 0, fd;
+	const char *m;
+	FILE *f;
+	switch(flags & LX_O_ACCMODE) {
+	case 0:		hf = O_RDONLY; m = "r"; break;
+	case 1:		hf = O_WRONLY; m = flags & LX_O_APPEND ? "a" : "w"; break;
+	default:	hf = O_RDWR; m = flags & LX_O_APPEND ? "a+" : "r+"; break;
+	}
+	if(flags & LX_O_CREAT)
+		hf |= O_CREAT;
+	if(flags & LX_O_EXCL)
+		hf |= O_EXCL;
+	if(flags & LX_O_TRUNC)
+		hf |= O_TRUNC;
+	if(flags & LX_O_APPEND)
+		hf |= O_APPEND;
+	fd = open(name, hf, mode);
+	if(fd < 0)
+		return NULL;
+	f = fdopen(fd, m);
+	if(f == NULL)
+		close(fd);
+	return f;
+}
+
+
+/**
+ * Perform a Linux EABI system call: number in r7, arguments in r0-r6,
+ * result or -errno in r0.
+ * @param state		Current state.
+ */
+void gliss_sys_call_eabi(gliss_state_t *state) {
+	gliss_sys_t *sys = state->sys;
+	uint32_t *a = state->GPR;
+	int32_t r = -1;
+	char name[PATH_SIZE];
+	FILE *f;
+
+	gliss_spy_suspend(state);
+	sys->err = 0;
+	switch(a[7]) {
+	case NR_EXIT:
+	case NR_EXIT_GROUP:
+		sys_exit(state, a[0]);
+		break;
+	case NR_READ:
+		r = sys_read(state, a[0], a[1], a[2]);
+		break;
+	case NR_WRITE:
+		r = sys_write(state, a[0], a[1], a[2]);
+		break;
+	case NR_OPEN:
+		if(sys_name(state, a[0], -1, name) != NULL)
+			r = sys_add(sys, sys_open(name, a[1], a[2]));
+		break;
+	case NR_CLOSE:
+		r = sys_close(sys, a[0]);
+		break;
+	case NR_LSEEK:
+		f = sys_file(sys, a[0], LAST_NONE);
+		if(f != NULL) {
+			int w = a[2] == 0 ? SEEK_SET : (a[2] == 1 ? SEEK_CUR : SEEK_END);
+			if(fseeko(f, (int32_t)a[1], w) == 0)
+				r = ftello(f);
+			else
+				sys->err = errno;
+		}
+		break;
+	case NR_TIMES: {
+			struct timespec now;
+			uint32_t t = clock() / (CLOCKS_PER_SEC / 100);
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			if(a[0] != 0) {
+				gliss_mem_write32(state->M, a[0], t);
+				gliss_mem_write32(state->M, a[0] + 4, 0);
+				gliss_mem_write32(state->M, a[0] + 8, 0);
+				gliss_mem_write32(state->M, a[0] + 12, 0);
+			}
+			r = (now.tv_sec - sys->start.tv_sec) * 100 + (now.tv_nsec - sys->start.tv_nsec) / 10000000;
+		}
+		break;
+	case NR_BRK:
+		if(a[0] != 0)
+			sys->brk = a[0];
+		r = sys->brk;
+		break;
+	case NR_GETTIMEOFDAY: {
+			struct timeval tv;
+			gettimeofday(&tv, NULL);
+			if(a[0] != 0) {
+				gliss_mem_write32(state->M, a[0], tv.tv_sec);
+				gliss_mem_write32(state->M, a[0] + 4, tv.tv_usec);
+			}
+			r = 0;
+		}
+		break;
+	case NR_CLOCK_GETTIME: {
+			struct timespec ts;
+			if(clock_gettime(a[0] == 0 ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts) != 0)
+				sys->err = errno;
+			else {
+				gliss_mem_write32(state->M, a[1], ts.tv_sec);
+				gliss_mem_write32(state->M, a[1] + 4, ts.tv_nsec);
+				r = 0;
+			}
+		}
+		break;
+	default:
+		sys->err = ENOSYS;
+		break;
+	}
+	state->GPR[0] = r < 0 && sys->err != 0 ? -sys->err : r;
+	gliss_spy_resume(state);
+}
+
+
+/**
+ * Hook of SVC (SWI) instructions.
+ * @param state		Current state.
+ * @param num		Immediate of the instruction.
+ * @return			1 if the call has been performed, 0 else.
+ */
+uint32_t gliss_sys_call_svc(gliss_state_t *state, uint32_t num) {
+	if(state->sys == NULL)
+		return 0;
+	if(num == GLISS_SEMIHOST_ARM || num == GLISS_SEMIHOST_THUMB)
+		gliss_sys_call_semihost(state);
+	else if(num == 0)
+		gliss_sys_call_eabi(state);
+	else
+		return 0;
+	return 1;
+}
+
+
+/**
+ * Hook of SVC (SWI) instructions when the exceptions are simulated:
+ * only the semihosting calls are performed by the host.
+ * @param state		Current state.
+ * @param num		Immediate of the instruction.
+ * @return			1 if the call has been performed, 0 else.
+ */
+uint32_t gliss_sys_call_svc_semihost(gliss_state_t *state, uint32_t num) {
+	if(state->sys == NULL || (num != GLISS_SEMIHOST_ARM && num != GLISS_SEMIHOST_THUMB))
+		return 0;
+	gliss_sys_call_semihost(state);
+	return 1;
+}
+
+
+/**
+ * Hook of BKPT instructions.
+ * @param state		Current state.
+ * @param num		Immediate of the instruction.
+ * @return			1 if the call has been performed, 0 else.
+ */
+uint32_t gliss_sys_call_bkpt(gliss_state_t *state, uint32_t num) {
+	if(state->sys == NULL || num != GLISS_SEMIHOST_THUMB)
+		return 0;
+	gliss_sys_call_semihost(state);
+	return 1;
+}
+
+
+/**
+ * Report a fault of the guest and stop the simulation, as a host system
+ * would kill the faulty process.
+ * @param state		Current state.
+ * @param sig		Matching signal (SIGILL or SIGBUS).
+ * @param addr		Instruction address.
+ * @param data		Data address (SIGBUS).
+ */
+void gliss_sys_call_fault(gliss_state_t *state, int sig, uint32_t addr, uint32_t data) {
+	fflush(stdout);
+	if(sig == SIGBUS)
+		fprintf(stderr, "ERROR: data abort at %08x (address %08x)\n", addr, data);
+	else
+		fprintf(stderr, "ERROR: undefined instruction at %08x\n", addr);
+	sys_exit(state, 128 + sig);
 }
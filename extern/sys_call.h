@@ -1,19 +1,72 @@
+/*!
+ * Host system calls
+ *
+ * \file sys_call.h
+ *
+ * Two conventions are served by the host:
+ *	- ARM semihosting (BKPT 0xAB and SVC 0xAB in Thumb, SVC 0x123456 in ARM):
+ *	  operation in r0, parameter (or parameter block address) in r1, result in r0,
+ *	  as used by newlib with --specs=rdimon.specs,
+ *	- Linux EABI system calls (SVC 0): number in r7, arguments in r0-r6,
+ *	  result or -errno in r0 (exit, read, write, open, close, lseek, times, brk,
+ *	  gettimeofday, clock_gettime).
+ *
+ * Guest file descriptors are mapped to buffered host streams so that a guest
+ * writing one character at a time does not cost one host system call per
+ * character. The streams are flushed when the guest exits and when the state
+ * is destroyed.
+ */
+
 #ifndef GLISS_SYS_CALL_H
 #define GLISS_SYS_CALL_H
 
+#include <stdint.h>
+#include <signal.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
-#define GLISS_SYS_CALL_STATE
-#define GLISS_SYS_CALL_INIT(s)
-#define GLISS_SYS_CALL_DESTROY(s)
+struct gliss_state_t;
+struct gliss_sys_t;
+
+#define GLISS_SYS_CALL_STATE		struct gliss_sys_t *sys; int spy_quiet;
+#define GLISS_SYS_CALL_INIT(s)		gliss_sys_call_init(s)
+#define GLISS_SYS_CALL_DESTROY(s)	gliss_sys_call_destroy(s)
+
+/* semihosting call numbers */
+#define GLISS_SEMIHOST_ARM		0x123456
+#define GLISS_SEMIHOST_THUMB	0xab
 
-void swi_impl(int code);
+/* instruction hooks (state is in scope, see nmp/exn-out.nmp and nmp/exn-in.nmp):
+ * return 1 if the call has been performed by the host, 0 if the instruction
+ * must behave as usual */
+#define gliss_svc(n)			gliss_sys_call_svc(state, (n))
+#define gliss_semihost(n)		gliss_sys_call_svc_semihost(state, (n))
+#define gliss_bkpt(n)			gliss_sys_call_bkpt(state, (n))
+
+/* accesses of the simulator itself (system calls, timing model reads of the
+ * instruction image): the memory spies (cache, trace) ignore the accesses of
+ * the state s between suspend and resume */
+#define gliss_spy_suspend(s)	((s)->spy_quiet++)
+#define gliss_spy_resume(s)		((s)->spy_quiet--)
+
+/* faults handled out of the simulator (report and exit with 128 + signal) */
+#define gliss_undefined(a)		gliss_sys_call_fault(state, SIGILL, (a), 0)
+#define gliss_data_abort(a, d)	gliss_sys_call_fault(state, SIGBUS, (a), (d))
+
+void gliss_sys_call_init(struct gliss_state_t *state);
+void gliss_sys_call_destroy(struct gliss_state_t *state);
+uint32_t gliss_sys_call_svc(struct gliss_state_t *state, uint32_t num);
+uint32_t gliss_sys_call_svc_semihost(struct gliss_state_t *state, uint32_t num);
+uint32_t gliss_sys_call_bkpt(struct gliss_state_t *state, uint32_t num);
+void gliss_sys_call_fault(struct gliss_state_t *state, int sig, uint32_t addr, uint32_t data);
+void gliss_sys_call_semihost(struct gliss_state_t *state);
+void gliss_sys_call_eabi(struct gliss_state_t *state);
+void gliss_sys_call_flush(struct gliss_state_t *state);
 
 #if defined(__cplusplus)
 }
 #endif
 
-
 #endif /* GLISS_SYS_CALL_H */
@@ -0,0 +1,224 @@
+/*!
+ * Cycle-approximate timing model (Cortex-M4)
+ *
+ * \file timing.c
+ *
+ * The latencies come from the Cortex-M4 technical reference manual,
+ * assuming zero-wait-state data memory. The model is approximate: an
+ * instruction whose condition fails is charged as executed, a load is
+ * pipelined with any previous load (not only with independent ones) and
+ * the sequential fetches from the flash are considered as hidden by the
+ * prefetch buffer, only the fetch of a branch target paying the wait states.
+ *
+ * The descriptions generated in src/timing_info.c ("class base") are decoded
+ * once into a compact table indexed by instruction identifier so that the
+ * probe of an ALU instruction costs one table load and a few additions.
+ *
+ * If the environment variable ARM_TIMING_OUT is set when the state is
+ * created, the cycle and instruction counts are written to the named file
+ * when the state is destroyed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gliss/api.h>
+#include <gliss/id.h>
+#include <gliss/mem.h>
+#include <gliss/sys_call.h>
+#include <gliss/timing.h>
+
+/* longest divide (SDIV, UDIV) */
+#define DIV_MAX		12
+
+gliss_timing_info_t gliss_timing_info[GLISS_TOP];
+
+static const char *classes[] = {
+	"alu", "load", "lsm", "lsm2", "lsm8", "lsm9", "vlsm", "vlsm2", "mla", "div", NULL
+};
+static int ready = 0;
+
+
+/**
+ * Decode the generated descriptions in gliss_timing_info.
+ */
+static void decode(void) {
+	char name[16];
+	int i, j, base;
+	for(i = 0; i < GLISS_TOP; i++) {
+		gliss_timing_info[i].base = 1;
+		gliss_timing_info[i].cls = GLISS_TIMING_ALU;
+		if(sscanf(gliss_timing_desc[i], "%15s %d", name, &base) != 2) {
+			fprintf(stderr, "ERROR: bad timing \"%s\"\n", gliss_timing_desc[i]);
+			continue;
+		}
+		for(j = 0; classes[j] != NULL; j++)
+			if(strcmp(classes[j], name) == 0)
+				break;
+		if(classes[j] == NULL)
+			fprintf(stderr, "ERROR: unknown timing class \"%s\"\n", name);
+		else {
+			gliss_timing_info[i].base = base;
+			gliss_timing_info[i].cls = j;
+		}
+	}
+	ready = 1;
+}
+
+
+/**
+ * Initialize the timing of a new state.
+ * @param state		Initialized state.
+ */
+void gliss_timing_init(gliss_state_t *state) {
+	const char *ws = getenv("ARM_TIMING_FLASH_WS");
+	if(!ready)
+		decode();
+	gliss_timing_reset(state);
+	state->tm_ws = ws == NULL ? 0 : strtoul(ws, NULL, 0);
+}
+
+
+/**
+ * Release the timing of a state, dumping the counts before if required
+ * by ARM_TIMING_OUT.
+ * @param state		Destroyed state.
+ */
+void gliss_timing_destroy(gliss_state_t *state) {
+	const char *path = getenv("ARM_TIMING_OUT");
+	FILE *out;
+	if(path == NULL)
+		return;
+	out = fopen(path, "w");
+	if(out == NULL || gliss_timing_dump(state, out) != 0)
+		fprintf(stderr, "ERROR: cannot dump timing to %s\n", path);
+	if(out != NULL)
+		fclose(out);
+}
+
+
+/**
+ * Reset the cycle and instruction counts to 0.
+ * @param state		State to reset.
+ */
+void gliss_timing_reset(gliss_state_t *state) {
+	state->tm_cycles = 0;
+	state->tm_insts = 0;
+	state->tm_next = 0;
+	state->tm_load = 0;
+}
+
+
+/**
+ * Get the number of elapsed cycles.
+ * @param state		Current state.
+ * @return			Cycle count.
+ */
+uint64_t gliss_timing_cycles(gliss_state_t *state) {
+	return state->tm_cycles;
+}
+
+
+/**
+ * Get the number of executed instructions.
+ * @param state		Current state.
+ * @return			Instruction count.
+ */
+uint64_t gliss_timing_insts(gliss_state_t *state) {
+	return state->tm_insts;
+}
+
+
+/**
+ * Output the cycle and instruction counts.
+ * @param state		Current state.
+ * @param out		Output stream.
+ * @return			0 for success, -1 else.
+ */
+int gliss_timing_dump(gliss_state_t *state, FILE *out) {
+	fprintf(out, "cycles %llu\ninstructions %llu\n",
+		(unsigned long long)state->tm_cycles, (unsigned long long)state->tm_insts);
+	if(state->tm_insts != 0)
+		fprintf(out, "CPI %.3f\n", (double)state->tm_cycles / state->tm_insts);
+	return ferror(out) ? -1 : 0;
+}
+
+
+/**
+ * Compute the cycles of a divide beyond its base latency: the M4 divider
+ * terminates early, depending on the number of quotient bits.
+ * @param state		Current state.
+ * @param base		Base latency.
+ * @param addr		Address of the SDIV or UDIV (Thumb-2).
+ * @return			Extra cycles.
+ */
+static int div_cycles(gliss_state_t *state, int base, uint32_t addr) {
+	uint16_t hw1 = gliss_mem_read16(state->M, addr), hw2 = gliss_mem_read16(state->M, addr + 2);
+	uint32_t n = state->GPR[hw1 & 0xf], d = state->GPR[hw2 & 0xf];
+	int q, c;
+	if(!(hw1 & 0x20)) {
+		if((int32_t)n < 0)
+			n = -n;
+		if((int32_t)d < 0)
+			d = -d;
+	}
+	if(d == 0 || n < d)
+		return 0;
+	q = __builtin_clz(d) - __builtin_clz(n) + 1;
+	c = (q + 2) / 3;
+	return base + c > DIV_MAX ? DIV_MAX - base : c;
+}
+
+
+/**
+ * Compute the class-dependent cycles of an instruction.
+ * @param state		Current state.
+ * @param info		Timing of the instruction.
+ * @param addr		Instruction address.
+ * @return			Cycles to add to the base latency (may be negative).
+ */
+static int extra_cycles(gliss_state_t *state, const gliss_timing_info_t *info, uint32_t addr) {
+	int load = state->tm_load;
+	state->tm_load = 0;
+	switch(info->cls) {
+	case GLISS_TIMING_LOAD:
+		state->tm_load = 1;
+		return load ? -1 : 0;
+	case GLISS_TIMING_LSM:
+		return __builtin_popcount(gliss_mem_read16(state->M, addr));
+	case GLISS_TIMING_LSM2:
+		return __builtin_popcount(gliss_mem_read16(state->M, addr + 2));
+	case GLISS_TIMING_LSM8:
+		return __builtin_popcount(gliss_mem_read16(state->M, addr) & 0xff);
+	case GLISS_TIMING_LSM9:
+		return __builtin_popcount(gliss_mem_read16(state->M, addr) & 0x1ff);
+	case GLISS_TIMING_VLSM:
+		return gliss_mem_read8(state->M, addr);
+	case GLISS_TIMING_VLSM2:
+		return gliss_mem_read8(state->M, addr + 2);
+	case GLISS_TIMING_MLA:
+		return (gliss_mem_read16(state->M, addr + 2) >> 12) != 0xf;
+	case GLISS_TIMING_DIV:
+		return div_cycles(state, info->base, addr);
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * Compute the class-dependent cycles of an instruction (not called for
+ * GLISS_TIMING_ALU). The operands are read from the instruction image
+ * and from the registers, before the instruction is executed; these reads
+ * are hidden from the memory spies.
+ * @param state		Current state.
+ * @param info		Timing of the instruction.
+ * @param addr		Instruction address.
+ * @return			Cycles to add to the base latency (may be negative).
+ */
+int gliss_timing_extra(gliss_state_t *state, const gliss_timing_info_t *info, uint32_t addr) {
+	int c;
+	gliss_spy_suspend(state);
+	c = extra_cycles(state, info, addr);
+	gliss_spy_resume(state);
+	return c;
+}
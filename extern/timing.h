@@ -0,0 +1,99 @@
+/*!
+ * Cycle-approximate timing model (Cortex-M4)
+ *
+ * \file timing.h
+ *
+ * Only linked when WITH_TIMING is configured: the instruction probe
+ * (nmp/probe-on.nmp) then adds the cost of each instruction to a cycle
+ * counter of the state. The cost is the base latency of the instruction
+ * identifier, from src/timing_info.c generated by gliss-attr from
+ * nmp/timing.nmp, plus a class-dependent part (register count of LDM/STM,
+ * divide operands, pipelined loads) and the pipeline refill of a taken
+ * branch, detected when an instruction does not follow the previous one.
+ * Fetches from the flash (code region, up to GLISS_TIMING_FLASH_TOP) after
+ * a taken branch also cost the wait states given by ARM_TIMING_FLASH_WS.
+ *
+ * Extra cycles (beyond one per instruction) are also charged to the event
+ * scheduler (extern/events.h) so that its time and the SysTick count cycles.
+ */
+
+#ifndef GLISS_TIMING_H
+#define GLISS_TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+
+#define GLISS_TIMING_STATE \
+	uint64_t tm_cycles; \
+	uint64_t tm_insts; \
+	uint32_t tm_next; \
+	uint32_t tm_ws; \
+	int tm_load;
+#define GLISS_TIMING_INIT(s)	gliss_timing_init(s)
+#define GLISS_TIMING_DESTROY(s)	gliss_timing_destroy(s)
+
+/* code region considered as flash (from address 0) */
+#define GLISS_TIMING_FLASH_TOP	0x1fffffff
+
+/* pipeline refill of a taken branch (without wait states) */
+#define GLISS_TIMING_REFILL		2
+
+/* instruction classes (cost computed from the base latency) */
+#define GLISS_TIMING_ALU		0	/* base */
+#define GLISS_TIMING_LOAD		1	/* base, 1 less just after a load */
+#define GLISS_TIMING_LSM		2	/* base + registers (ARM, list in bits 15..0) */
+#define GLISS_TIMING_LSM2		3	/* base + registers (Thumb-2, list in 2nd half-word) */
+#define GLISS_TIMING_LSM8		4	/* base + registers (Thumb, list in bits 7..0) */
+#define GLISS_TIMING_LSM9		5	/* base + registers (PUSH/POP, LR/PC in bit 8) */
+#define GLISS_TIMING_VLSM		6	/* base + words (ARM VLDM/VSTM, imm8) */
+#define GLISS_TIMING_VLSM2		7	/* base + words (Thumb-2 VLDM/VSTM, imm8) */
+#define GLISS_TIMING_MLA		8	/* base, 1 more with an accumulator */
+#define GLISS_TIMING_DIV		9	/* base to 12, early termination */
+
+typedef struct gliss_timing_info_t {
+	uint8_t base;
+	uint8_t cls;
+} gliss_timing_info_t;
+extern gliss_timing_info_t gliss_timing_info[];
+
+/* generated from nmp/timing.nmp ("class base" by identifier), compiled
+ * into gliss_timing_info when the first state is created */
+extern const char *gliss_timing_desc[];
+
+int gliss_timing_extra(struct gliss_state_t *state, const gliss_timing_info_t *info, uint32_t addr);
+
+/* instruction probe: s is the state, i the instruction, a its address, z its size */
+#define gliss_timing_inst(s, i, a, z) \
+	{ \
+		const gliss_timing_info_t *_ti = &gliss_timing_info[(i)->ident]; \
+		int _c = _ti->base; \
+		if((a) != (s)->tm_next) \
+			_c += GLISS_TIMING_REFILL + ((a) <= GLISS_TIMING_FLASH_TOP ? (int)(s)->tm_ws : 0); \
+		if(_ti->cls != GLISS_TIMING_ALU) \
+			_c += gliss_timing_extra((s), _ti, (a)); \
+		else \
+			(s)->tm_load = 0; \
+		(s)->tm_next = (a) + (z); \
+		(s)->tm_cycles += _c; \
+		(s)->tm_insts++; \
+		(s)->ev_left -= _c - 1; \
+	}
+
+void gliss_timing_init(struct gliss_state_t *state);
+void gliss_timing_destroy(struct gliss_state_t *state);
+void gliss_timing_reset(struct gliss_state_t *state);
+uint64_t gliss_timing_cycles(struct gliss_state_t *state);
+uint64_t gliss_timing_insts(struct gliss_state_t *state);
+int gliss_timing_dump(struct gliss_state_t *state, FILE *out);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_TIMING_H */
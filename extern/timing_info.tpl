@@ -0,0 +1,9 @@
+/* Generated by gliss-attr ($(date)) from nmp/timing.nmp -- do not edit */
+#include <arm/api.h>
+#include <arm/id.h>
+#include <arm/timing.h>
+
+const char *arm_timing_desc[] = {
+	"alu 1"$(foreach instructions),
+	$(timing)$(end)
+};
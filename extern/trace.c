@@ -0,0 +1,223 @@
+/*!
+ * Streaming execution trace
+ *
+ * \file trace.c
+ *
+ * The simulator thread is the only producer and the writer thread the only
+ * consumer of the ring buffer: head is only written by the former, tail by
+ * the latter, so no lock is needed. The producer only waits when the buffer
+ * is full, that is, when the disk is slower than the simulator.
+ *
+ * If the environment variable ARM_TRACE_OUT is set when the state is
+ * created, the trace is started to the named file.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <gliss/api.h>
+#include <gliss/mem.h>
+#include <gliss/sys_call.h>
+#include <gliss/trace.h>
+
+#define RING_SIZE	(1 << 16)	/* in records, power of 2 */
+#define OUT_SIZE	(1 << 16)	/* in bytes */
+#define REC_MAX		6			/* tag + 5-bytes LEB128 */
+
+typedef struct rec_t {
+	uint32_t addr;
+	uint32_t tag;
+} rec_t;
+
+typedef struct gliss_trace_t {
+	rec_t ring[RING_SIZE];
+	uint32_t head;					/* producer copy */
+	_Atomic uint32_t pub_head;		/* published by the producer */
+	_Atomic uint32_t tail;			/* published by the consumer */
+	_Atomic int closing;
+	pthread_t writer;
+	FILE *out;
+
+	/* encoder state (writer thread only) */
+	uint32_t next_pc;
+	uint32_t last_addr;
+	uint8_t buf[OUT_SIZE];
+	int len;
+} gliss_trace_t;
+
+
+/**
+ * Encode a record in the output buffer.
+ * @param t		Trace.
+ * @param r		Record to encode.
+ */
+static void encode(gliss_trace_t *t, rec_t *r) {
+	uint32_t exp, z;
+	int32_t d;
+
+	/* flush if needed */
+	if(t->len + REC_MAX > OUT_SIZE) {
+		fwrite(t->buf, 1, t->len, t->out);
+		t->len = 0;
+	}
+
+	/* compute the delta */
+	if(GLISS_TRACE_KIND(r->tag) == GLISS_TRACE_INST) {
+		exp = t->next_pc;
+		t->next_pc = r->addr + (r->tag & GLISS_TRACE_INST32 ? 4 : 2);
+		if(r->addr == exp) {
+			t->buf[t->len++] = r->tag | GLISS_TRACE_SEQ;
+			return;
+		}
+	}
+	else {
+		exp = t->last_addr;
+		t->last_addr = r->addr;
+	}
+	t->buf[t->len++] = r->tag;
+
+	/* zig-zag + LEB128 */
+	d = (int32_t)(r->addr - exp);
+	z = ((uint32_t)d << 1) ^ (uint32_t)(d >> 31);
+	while(z >= 0x80) {
+		t->buf[t->len++] = (z & 0x7f) | 0x80;
+		z >>= 7;
+	}
+	t->buf[t->len++] = z;
+}
+
+
+/**
+ * Writer thread: drain the ring buffer to the file.
+ * @param arg	Trace.
+ * @return		Nothing.
+ */
+static void *writer(void *arg) {
+	gliss_trace_t *t = (gliss_trace_t *)arg;
+	struct timespec wait = { 0, 50000 };
+	uint32_t tail = atomic_load_explicit(&t->tail, memory_order_relaxed);
+
+	while(1) {
+		uint32_t head = atomic_load_explicit(&t->pub_head, memory_order_acquire);
+		if(head == tail) {
+			if(atomic_load_explicit(&t->closing, memory_order_acquire)
+			&& head == atomic_load_explicit(&t->pub_head, memory_order_acquire))
+				break;
+			nanosleep(&wait, NULL);
+			continue;
+		}
+		for(; tail != head; tail++)
+			encode(t, &t->ring[tail & (RING_SIZE - 1)]);
+		atomic_store_explicit(&t->tail, tail, memory_order_release);
+	}
+
+	fwrite(t->buf, 1, t->len, t->out);
+	t->len = 0;
+	return NULL;
+}
+
+
+/**
+ * Push a record in the ring buffer (simulator thread only).
+ * @param t		Trace.
+ * @param addr	Record address.
+ * @param tag	Record tag.
+ */
+void gliss_trace_push(gliss_trace_t *t, uint32_t addr, uint32_t tag) {
+	uint32_t h = t->head;
+	while(h - atomic_load_explicit(&t->tail, memory_order_acquire) >= RING_SIZE)
+		sched_yield();
+	t->ring[h & (RING_SIZE - 1)].addr = addr;
+	t->ring[h & (RING_SIZE - 1)].tag = tag;
+	t->head = h + 1;
+	atomic_store_explicit(&t->pub_head, h + 1, memory_order_release);
+}
+
+
+#ifdef GLISS_MEM_IO
+	/**
+	 * Memory call-back recording the accesses.
+	 * @param addr			Accessed address.
+	 * @param size			Accessed size.
+	 * @param data			Read / written data.
+	 * @param type_access	Read or write.
+	 * @param cdata			Traced state.
+	 */
+	static void trace_memory(gliss_address_t addr, int size, void *data, int type_access, void *cdata) {
+		gliss_state_t *state = (gliss_state_t *)cdata;
+		if(state->trace == NULL || state->spy_quiet != 0)
+			return;
+		gliss_trace_push(state->trace, addr,
+			(type_access == GLISS_MEM_READ ? GLISS_TRACE_READ : GLISS_TRACE_WRITE)
+			| (((size - 1) & 0x1f) << 2));
+	}
+#endif
+
+
+/**
+ * Initialize the trace of a state, starting it if ARM_TRACE_OUT is set.
+ * @param state		Initialized state.
+ */
+void gliss_trace_init(gliss_state_t *state) {
+	const char *path = getenv("ARM_TRACE_OUT");
+	state->trace = NULL;
+	state->trace_hooked = 0;
+	if(path != NULL && gliss_trace_start(state, path) != 0)
+		fprintf(stderr, "ERROR: cannot open trace %s\n", path);
+}
+
+
+/**
+ * Start tracing a state. If a trace is already running, it is stopped.
+ * @param state		State to trace.
+ * @param path		Path of the trace file.
+ * @return			0 for success, -1 else.
+ */
+int gliss_trace_start(gliss_state_t *state, const char *path) {
+	gliss_trace_t *t;
+
+	gliss_trace_stop(state);
+	t = (gliss_trace_t *)calloc(1, sizeof(gliss_trace_t));
+	if(t == NULL)
+		return -1;
+	t->out = fopen(path, "wb");
+	if(t->out == NULL) {
+		free(t);
+		return -1;
+	}
+	fwrite(GLISS_TRACE_MAGIC, 1, 8, t->out);
+	if(pthread_create(&t->writer, NULL, writer, t) != 0) {
+		fclose(t->out);
+		free(t);
+		return -1;
+	}
+
+#	ifdef GLISS_MEM_IO
+		if(!state->trace_hooked) {
+			gliss_set_range_callback_ex(state->M, 0, 0xffffffff, trace_memory, state, GLISS_MEM_SPY);
+			state->trace_hooked = 1;
+		}
+#	endif
+	state->trace = t;
+	return 0;
+}
+
+
+/**
+ * Stop the trace of a state (if any) and flush it.
+ * @param state		Traced state.
+ */
+void gliss_trace_stop(gliss_state_t *state) {
+	gliss_trace_t *t = state->trace;
+	if(t == NULL)
+		return;
+	state->trace = NULL;
+	atomic_store_explicit(&t->closing, 1, memory_order_release);
+	pthread_join(t->writer, NULL);
+	fclose(t->out);
+	free(t);
+}
@@ -0,0 +1,66 @@
+/*!
+ * Streaming execution trace
+ *
+ * \file trace.h
+ *
+ * Only linked when WITH_TRACE is configured. Once started, each executed
+ * instruction (address and size) and, with WITH_IO, each memory access
+ * of the guest (address, size and direction) is pushed in a lock-free ring
+ * buffer; the accesses of the simulator itself (see gliss_spy_suspend() in
+ * extern/sys_call.h) are not recorded.
+ * A writer thread drains the buffer and encodes the records in the file.
+ *
+ * File format: the header GLISS_TRACE_MAGIC (8 bytes) followed by records
+ * made of a tag byte, possibly followed by a delta:
+ *	- bits 1-0: kind (GLISS_TRACE_INST, GLISS_TRACE_READ, GLISS_TRACE_WRITE),
+ *	- instruction: bit 2 is set for 32-bit instructions, bit 3 is set if
+ *	  the instruction follows sequentially the previous one (no delta),
+ *	- memory access: bits 6-2 give the size in bytes minus one.
+ * The delta is a zig-zag LEB128 encoded difference with the expected address:
+ * the address following the previous instruction for instructions, the
+ * address of the previous access for memory accesses.
+ * A reader is provided in the trace directory.
+ */
+
+#ifndef GLISS_TRACE_H
+#define GLISS_TRACE_H
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+struct gliss_trace_t;
+
+#define GLISS_TRACE_STATE		struct gliss_trace_t *trace; int trace_hooked;
+#define GLISS_TRACE_INIT(s)		gliss_trace_init(s)
+#define GLISS_TRACE_DESTROY(s)	gliss_trace_stop(s)
+
+/* record kinds */
+#define GLISS_TRACE_INST		0
+#define GLISS_TRACE_READ		1
+#define GLISS_TRACE_WRITE		2
+
+/* record format */
+#define GLISS_TRACE_MAGIC		"GLTRACE1"
+#define GLISS_TRACE_KIND(t)		((t) & 0x3)
+#define GLISS_TRACE_INST32		0x04
+#define GLISS_TRACE_SEQ			0x08
+#define GLISS_TRACE_SIZE(t)		((((t) >> 2) & 0x1f) + 1)
+
+/* instruction probe: s is the state, a the address, z the size */
+#define gliss_trace_inst(s, a, z) \
+	{ if((s)->trace != 0) gliss_trace_push((s)->trace, (a), GLISS_TRACE_INST | (((z) == 4) << 2)); }
+
+void gliss_trace_init(struct gliss_state_t *state);
+int gliss_trace_start(struct gliss_state_t *state, const char *path);
+void gliss_trace_stop(struct gliss_state_t *state);
+void gliss_trace_push(struct gliss_trace_t *trace, uint32_t addr, uint32_t tag);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_TRACE_H */
@@ -0,0 +1,495 @@
+/*!
+ * Unified VFP register file
+ *
+ * \file vfp.c
+ *
+ * Out-of-line accessors to the double-precision registers for code
+ * outside of the simulator (debuggers, validator, OTAWA) and Advanced SIMD
+ * operations.
+ *
+ * The SIMD operations work on a whole D (64-bit) or Q (128-bit) register at
+ * once. When the host supports SSE2 (always the case on x86-64), they are
+ * implemented with SSE2 intrinsics; otherwise a portable lane-by-lane version
+ * is used. The floating-point operations follow the plain host arithmetic,
+ * like the VFP instructions, except VMAX/VMIN that implement the ARM
+ * handling of NaN (default NaN) and of signed zeros.
+ *
+ * On x86-64 hosts, the FPSCR modes and flags are mapped on the MXCSR register
+ * that controls all scalar and SSE floating-point operations (no need for
+ * the math library). Other hosts use the C99 floating-point environment
+ * (and therefore need -lm); flush-to-zero is not supported there.
+ */
+
+#include <gliss/api.h>
+#include <gliss/vfp.h>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+#if defined(__SSE2__) && defined(__x86_64__)
+#	define HOST_MXCSR
+#else
+#	include <fenv.h>
+#	include <math.h>
+#endif
+
+/* FPSCR bits */
+#define FPSCR_IOC		0x00000001
+#define FPSCR_DZC		0x00000002
+#define FPSCR_OFC		0x00000004
+#define FPSCR_UFC		0x00000008
+#define FPSCR_IXC		0x00000010
+#define FPSCR_RMODE(v)	(((v) >> 22) & 3)
+#define FPSCR_FZ		0x01000000
+#define FPSCR_DN		0x02000000
+
+#ifdef HOST_MXCSR
+	/* MXCSR bits */
+#	define MXCSR_IE		0x0001
+#	define MXCSR_ZE		0x0004
+#	define MXCSR_OE		0x0008
+#	define MXCSR_UE		0x0010
+#	define MXCSR_PE		0x0020
+#	define MXCSR_FLAGS	0x003f
+#	define MXCSR_DAZ	0x0040
+#	define MXCSR_RC		0x6000
+#	define MXCSR_FTZ	0x8000
+#	define raise_invalid()	_mm_setcsr(_mm_getcsr() | MXCSR_IE)
+#else
+#	define raise_invalid()	feraiseexcept(FE_INVALID)
+#endif
+
+#define DEFAULT_NAN		0x7fc00000
+
+/**
+ * Get the value of a double-precision register.
+ * @param state		Current state.
+ * @param i			Register number (0 to GLISS_VFP_DCOUNT-1).
+ * @return			Register value.
+ */
+double gliss_vfp_get_double(struct gliss_state_t *state, int i) {
+	return gliss_vfp_load_d(GLISS_VFP_DREG(state, i));
+}
+
+/**
+ * Set the value of a double-precision register.
+ * @param state		Current state.
+ * @param i			Register number (0 to GLISS_VFP_DCOUNT-1).
+ * @param v			Value to set.
+ */
+void gliss_vfp_set_double(struct gliss_state_t *state, int i, double v) {
+	gliss_vfp_store_d(GLISS_VFP_DREG(state, i), v);
+}
+
+
+
+/**
+ * Initialize the VFP part of the state: FPSCR is reset and the host
+ * floating-point unit is configured accordingly.
+ * @param state		Initialized state.
+ */
+void gliss_vfp_init(struct gliss_state_t *state) {
+	gliss_vfp_set_fpscr(state, 0);
+}
+
+
+/**
+ * Called each time FPSCR is written: install the rounding mode and the
+ * flush-to-zero mode in the host and clear the host exception flags
+ * (the cumulative bits are kept in FPSCR itself).
+ * @param state		Current state.
+ * @param fpscr		New value of FPSCR.
+ */
+void gliss_vfp_set_fpscr(struct gliss_state_t *state, uint32_t fpscr) {
+#	ifdef HOST_MXCSR
+		/* RN, RP, RM, RZ -> nearest, up, down, zero */
+		static const unsigned int rc[4] = { 0x0000, 0x4000, 0x2000, 0x6000 };
+		unsigned int csr = _mm_getcsr() & ~(MXCSR_RC | MXCSR_FTZ | MXCSR_DAZ | MXCSR_FLAGS);
+		csr |= rc[FPSCR_RMODE(fpscr)];
+		if(fpscr & FPSCR_FZ)
+			csr |= MXCSR_FTZ | MXCSR_DAZ;
+		_mm_setcsr(csr);
+#	else
+		static const int rm[4] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+		fesetround(rm[FPSCR_RMODE(fpscr)]);
+		feclearexcept(FE_ALL_EXCEPT);
+#	endif
+	state->vfp_dn = (fpscr & FPSCR_DN) != 0;
+}
+
+
+/**
+ * Called before FPSCR is read: accumulate the host exception flags raised
+ * since the last write in the cumulative bits of FPSCR. IDC is not reported
+ * as the host does not flag flushed denormal inputs.
+ * @param fpscr		Current value of FPSCR.
+ * @return			Up-to-date value of FPSCR.
+ */
+uint32_t gliss_vfp_get_fpscr(uint32_t fpscr) {
+#	ifdef HOST_MXCSR
+		unsigned int csr = _mm_getcsr();
+		if(csr & MXCSR_IE)
+			fpscr |= FPSCR_IOC;
+		if(csr & MXCSR_ZE)
+			fpscr |= FPSCR_DZC;
+		if(csr & MXCSR_OE)
+			fpscr |= FPSCR_OFC;
+		if(csr & MXCSR_UE)
+			fpscr |= FPSCR_UFC;
+		if(csr & MXCSR_PE)
+			fpscr |= FPSCR_IXC;
+#	else
+		if(fetestexcept(FE_INVALID))
+			fpscr |= FPSCR_IOC;
+		if(fetestexcept(FE_DIVBYZERO))
+			fpscr |= FPSCR_DZC;
+		if(fetestexcept(FE_OVERFLOW))
+			fpscr |= FPSCR_OFC;
+		if(fetestexcept(FE_UNDERFLOW))
+			fpscr |= FPSCR_UFC;
+		if(fetestexcept(FE_INEXACT))
+			fpscr |= FPSCR_IXC;
+#	endif
+	return fpscr;
+}
+
+
+/**
+ * Square root in the current rounding mode (without errno handling).
+ * @param x		Operand.
+ * @return		Square root of x.
+ */
+double gliss_vfp_sqrt(double x) {
+#	ifdef HOST_MXCSR
+		__m128d v = _mm_set_sd(x);
+		return _mm_cvtsd_f64(_mm_sqrt_sd(v, v));
+#	else
+		return sqrt(x);
+#	endif
+}
+
+
+/**
+ * Convert a floating-point value to a 32-bit integer as VCVT does:
+ * out-of-range values saturate and raise Invalid Operation only (not
+ * Inexact), NaN gives 0.
+ * @param x				Value to convert.
+ * @param is_unsigned	Non-zero for an unsigned result.
+ * @param round_zero	Non-zero to round towards zero, else use FPSCR rounding.
+ * @return				Converted value.
+ */
+uint32_t gliss_vfp_to_int(double x, int is_unsigned, int round_zero) {
+	int64_t i;
+	int64_t min = is_unsigned ? 0 : -2147483648LL;
+	int64_t max = is_unsigned ? 4294967295LL : 2147483647LL;
+#	ifdef HOST_MXCSR
+		unsigned int csr;
+#	else
+		fexcept_t inexact;
+#	endif
+
+	/* NaN and far out of range */
+	if(x != x) {
+		raise_invalid();
+		return 0;
+	}
+	if(x <= -4294967296.0 || x >= 8589934592.0) {
+		raise_invalid();
+		return x < 0 ? (uint32_t)min : (uint32_t)max;
+	}
+
+	/* conversion (inexact raised by the host, dropped if saturated) */
+#	ifdef HOST_MXCSR
+		csr = _mm_getcsr();
+#	else
+		fegetexceptflag(&inexact, FE_INEXACT);
+#	endif
+	if(round_zero)
+		i = (int64_t)x;
+	else {
+#		ifdef HOST_MXCSR
+			i = _mm_cvtsd_si64(_mm_set_sd(x));
+#		else
+			i = llrint(x);
+#		endif
+	}
+
+	/* saturation */
+	if(i < min || i > max) {
+#		ifdef HOST_MXCSR
+			_mm_setcsr(csr);
+#		else
+			fesetexceptflag(&inexact, FE_INEXACT);
+#		endif
+		raise_invalid();
+		i = i < min ? min : max;
+	}
+	return (uint32_t)i;
+}
+
+
+/* signaling NaN tests on the bits (the host comparison may quiet them) */
+static inline int is_snan32(float x) {
+	uint32_t b;
+	memcpy(&b, &x, sizeof(b));
+	return (b & 0x7fc00000) == 0x7f800000 && (b & 0x003fffff) != 0;
+}
+
+static inline int is_snan64(double x) {
+	uint64_t b;
+	memcpy(&b, &x, sizeof(b));
+	return (b & 0x7ff8000000000000ULL) == 0x7ff0000000000000ULL
+		&& (b & 0x0007ffffffffffffULL) != 0;
+}
+
+/**
+ * Compare two double-precision values as VCMP/VCMPE: a signaling NaN
+ * always raises Invalid Operation, a quiet NaN only for VCMPE.
+ * @param x		First operand.
+ * @param y		Second operand.
+ * @param e		Non-zero if quiet NaN must raise Invalid Operation (VCMPE).
+ * @return		NZCV flags (N in bit 3).
+ */
+uint32_t gliss_vfp_compare(double x, double y, int e) {
+	if(x != x || y != y) {
+		if(e || is_snan64(x) || is_snan64(y))
+			raise_invalid();
+		return 0x3;
+	}
+	else if(x == y)
+		return 0x6;
+	else if(x < y)
+		return 0x8;
+	else
+		return 0x2;
+}
+
+/**
+ * Compare two single-precision values as VCMP/VCMPE (see
+ * gliss_vfp_compare()). The operands are not converted to double before
+ * the NaN test as the conversion would quiet a signaling NaN.
+ * @param x		First operand.
+ * @param y		Second operand.
+ * @param e		Non-zero if quiet NaN must raise Invalid Operation (VCMPE).
+ * @return		NZCV flags (N in bit 3).
+ */
+uint32_t gliss_vfp_compare32(float x, float y, int e) {
+	if(x != x || y != y) {
+		if(e || is_snan32(x) || is_snan32(y))
+			raise_invalid();
+		return 0x3;
+	}
+	else if(x == y)
+		return 0x6;
+	else if(x < y)
+		return 0x8;
+	else
+		return 0x2;
+}
+
+
+#ifdef __SSE2__
+
+/* load/store a D (r = 1) or Q (r = 2) register */
+static inline __m128i load(const float *p, int r) {
+	if(r == 1)
+		return _mm_loadl_epi64((const __m128i *)p);
+	else
+		return _mm_loadu_si128((const __m128i *)p);
+}
+
+static inline void store(float *p, int r, __m128i v) {
+	if(r == 1)
+		_mm_storel_epi64((__m128i *)p, v);
+	else
+		_mm_storeu_si128((__m128i *)p, v);
+}
+
+#define loadf(p, r)		_mm_castsi128_ps(load(p, r))
+#define storef(p, r, v)	store(p, r, _mm_castps_si128(v))
+
+/**
+ * Perform a floating-point SIMD operation on 32-bit lanes.
+ * @param op	Operation (one of GLISS_SIMD_ADD to GLISS_SIMD_MIN).
+ * @param d		Destination D register.
+ * @param n		First operand D register.
+ * @param m		Second operand D register.
+ * @param regs	Number of D registers (1 or 2).
+ */
+void gliss_vfp_simd_f32(int op, float *d, const float *n, const float *m, int regs) {
+	__m128 a = loadf(n, regs), b = loadf(m, regs), r;
+	switch(op) {
+	case GLISS_SIMD_ADD:	r = _mm_add_ps(a, b); break;
+	case GLISS_SIMD_SUB:	r = _mm_sub_ps(a, b); break;
+	case GLISS_SIMD_MUL:	r = _mm_mul_ps(a, b); break;
+	case GLISS_SIMD_MLA:	r = _mm_add_ps(loadf(d, regs), _mm_mul_ps(a, b)); break;
+	case GLISS_SIMD_MLS:	r = _mm_sub_ps(loadf(d, regs), _mm_mul_ps(a, b)); break;
+	case GLISS_SIMD_MAX:
+	case GLISS_SIMD_MIN: {
+			/* equal operands (including +0/-0): combine the signs */
+			__m128 eq = _mm_cmpeq_ps(a, b);
+			__m128 un = _mm_cmpunord_ps(a, b);
+			__m128 x = op == GLISS_SIMD_MAX ? _mm_max_ps(a, b) : _mm_min_ps(a, b);
+			__m128 z = op == GLISS_SIMD_MAX ? _mm_and_ps(a, b) : _mm_or_ps(a, b);
+			r = _mm_or_ps(_mm_and_ps(eq, z), _mm_andnot_ps(eq, x));
+			r = _mm_or_ps(_mm_and_ps(un, _mm_castsi128_ps(_mm_set1_epi32(DEFAULT_NAN))), _mm_andnot_ps(un, r));
+		}
+		break;
+	default:
+		return;
+	}
+	storef(d, regs, r);
+}
+
+/**
+ * Perform an integer SIMD operation.
+ * @param op	Operation (GLISS_SIMD_ADD or GLISS_SIMD_SUB).
+ * @param size	Lane size (0 for 8-bit, 1 for 16-bit, 2 for 32-bit, 3 for 64-bit).
+ * @param d		Destination D register.
+ * @param n		First operand D register.
+ * @param m		Second operand D register.
+ * @param regs	Number of D registers (1 or 2).
+ */
+void gliss_vfp_simd_int(int op, int size, float *d, const float *n, const float *m, int regs) {
+	__m128i a = load(n, regs), b = load(m, regs), r;
+	if(op == GLISS_SIMD_ADD)
+		switch(size) {
+		case 0:		r = _mm_add_epi8(a, b); break;
+		case 1:		r = _mm_add_epi16(a, b); break;
+		case 2:		r = _mm_add_epi32(a, b); break;
+		default:	r = _mm_add_epi64(a, b); break;
+		}
+	else
+		switch(size) {
+		case 0:		r = _mm_sub_epi8(a, b); break;
+		case 1:		r = _mm_sub_epi16(a, b); break;
+		case 2:		r = _mm_sub_epi32(a, b); break;
+		default:	r = _mm_sub_epi64(a, b); break;
+		}
+	store(d, regs, r);
+}
+
+/**
+ * Perform a bitwise SIMD operation.
+ * @param op	Operation (one of GLISS_SIMD_AND, GLISS_SIMD_ORR, GLISS_SIMD_EOR).
+ * @param d		Destination D register.
+ * @param n		First operand D register.
+ * @param m		Second operand D register.
+ * @param regs	Number of D registers (1 or 2).
+ */
+void gliss_vfp_simd_bits(int op, float *d, const float *n, const float *m, int regs) {
+	__m128i a = load(n, regs), b = load(m, regs), r;
+	switch(op) {
+	case GLISS_SIMD_AND:	r = _mm_and_si128(a, b); break;
+	case GLISS_SIMD_ORR:	r = _mm_or_si128(a, b); break;
+	default:				r = _mm_xor_si128(a, b); break;
+	}
+	store(d, regs, r);
+}
+
+/**
+ * Duplicate a value in all lanes of a register.
+ * @param size	Lane size (0 for 8-bit, 1 for 16-bit, 2 for 32-bit).
+ * @param d		Destination D register.
+ * @param v		Value to duplicate.
+ * @param regs	Number of D registers (1 or 2).
+ */
+void gliss_vfp_simd_dup(int size, float *d, uint32_t v, int regs) {
+	__m128i r;
+	switch(size) {
+	case 0:		r = _mm_set1_epi8((char)v); break;
+	case 1:		r = _mm_set1_epi16((short)v); break;
+	default:	r = _mm_set1_epi32((int)v); break;
+	}
+	store(d, regs, r);
+}
+
+#else	/* __SSE2__ */
+
+/* portable version: lanes are processed one by one */
+
+static float fmax_arm(float a, float b, int max) {
+	uint32_t x, y, r;
+	if(a != a || b != b) {
+		r = DEFAULT_NAN;
+		memcpy(&a, &r, sizeof(a));
+		return a;
+	}
+	if(a == b) {
+		memcpy(&x, &a, sizeof(x));
+		memcpy(&y, &b, sizeof(y));
+		r = max ? x & y : x | y;
+		memcpy(&a, &r, sizeof(a));
+		return a;
+	}
+	if(max)
+		return a > b ? a : b;
+	else
+		return a < b ? a : b;
+}
+
+void gliss_vfp_simd_f32(int op, float *d, const float *n, const float *m, int regs) {
+	float r[4];
+	int i;
+	for(i = 0; i < 2 * regs; i++) {
+		float a = n[i], b = m[i];
+		switch(op) {
+		case GLISS_SIMD_ADD:	r[i] = a + b; break;
+		case GLISS_SIMD_SUB:	r[i] = a - b; break;
+		case GLISS_SIMD_MUL:	r[i] = a * b; break;
+		case GLISS_SIMD_MLA:	r[i] = d[i] + a * b; break;
+		case GLISS_SIMD_MLS:	r[i] = d[i] - a * b; break;
+		case GLISS_SIMD_MAX:	r[i] = fmax_arm(a, b, 1); break;
+		case GLISS_SIMD_MIN:	r[i] = fmax_arm(a, b, 0); break;
+		default:				return;
+		}
+	}
+	memcpy(d, r, 8 * regs);
+}
+
+void gliss_vfp_simd_int(int op, int size, float *d, const float *n, const float *m, int regs) {
+	uint8_t a[16], b[16], r[16];
+	int i, j, bytes = 1 << size;
+	memcpy(a, n, 8 * regs);
+	memcpy(b, m, 8 * regs);
+	for(i = 0; i < 8 * regs; i += bytes) {
+		uint64_t x = 0, y = 0, z;
+		for(j = bytes - 1; j >= 0; j--) {
+			x = (x << 8) | a[i + j];
+			y = (y << 8) | b[i + j];
+		}
+		z = op == GLISS_SIMD_ADD ? x + y : x - y;
+		for(j = 0; j < bytes; j++, z >>= 8)
+			r[i + j] = z;
+	}
+	memcpy(d, r, 8 * regs);
+}
+
+void gliss_vfp_simd_bits(int op, float *d, const float *n, const float *m, int regs) {
+	uint64_t a, b;
+	int i;
+	for(i = 0; i < regs; i++) {
+		a = gliss_vfp_load_d_bits(n + 2 * i);
+		b = gliss_vfp_load_d_bits(m + 2 * i);
+		switch(op) {
+		case GLISS_SIMD_AND:	a &= b; break;
+		case GLISS_SIMD_ORR:	a |= b; break;
+		default:				a ^= b; break;
+		}
+		gliss_vfp_store_d_bits(d + 2 * i, a);
+	}
+}
+
+void gliss_vfp_simd_dup(int size, float *d, uint32_t v, int regs) {
+	uint64_t r;
+	int i;
+	switch(size) {
+	case 0:		r = 0x0101010101010101ULL * (v & 0xff); break;
+	case 1:		r = 0x0001000100010001ULL * (v & 0xffff); break;
+	default:	r = 0x0000000100000001ULL * v; break;
+	}
+	for(i = 0; i < regs; i++)
+		gliss_vfp_store_d_bits(d + 2 * i, r);
+}
+
+#endif	/* __SSE2__ */
@@ -0,0 +1,149 @@
+/*!
+ * Unified VFP register file
+ *
+ * \file vfp.h
+ *
+ * The VFP registers are only stored once, as the S[32] bank of the state.
+ * The double-precision register Dn overlaps S(2n) (low word) and S(2n+1)
+ * (high word), as in the architecture, so that writing a D register is
+ * immediately seen through the S registers and conversely. D16 to D31 have
+ * no S alias and are stored in the vfp_dh array of the state.
+ *
+ * The accessors below are used from the NMP description (see fp.nmp) and
+ * perform a single 64-bit load or store. GLISS2 does not let us choose the
+ * alignment of the state structure, so the accesses go through memcpy()
+ * that the compiler turns into a plain move. The host is assumed to be
+ * little-endian, like the emulated memory layout.
+ *
+ * The Advanced SIMD instructions see the same file as 64-bit D registers
+ * or 128-bit Q registers (Qn = D(2n+1)::D(2n)) and are implemented with
+ * host SIMD instructions when available (see vfp.c).
+ *
+ * The FPSCR controls (rounding mode, flush-to-zero) are not checked at each
+ * operation: they are installed in the host floating-point unit when FPSCR
+ * is written (VMSR) and the cumulative exception bits are collected from the
+ * host flags only when FPSCR is read (VMRS). Default NaN is the only mode
+ * tested on each result (one comparison). As the host floating-point
+ * environment is per thread, simulators sharing a thread share it.
+ */
+
+#ifndef GLISS_VFP_H
+#define GLISS_VFP_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct gliss_state_t;
+
+/* number of D registers (VFPv3-D32 / Advanced SIMD) */
+#define GLISS_VFP_DCOUNT	32
+
+#define GLISS_VFP_STATE			int vfp_dn; float vfp_dh[2 * (GLISS_VFP_DCOUNT - 16)];
+#define GLISS_VFP_INIT(s)		gliss_vfp_init(s)
+#define GLISS_VFP_DESTROY(s)
+
+/* words of the D register i (0 to GLISS_VFP_DCOUNT-1) in the state s */
+#define GLISS_VFP_DREG(s, i)	((i) < 16 ? (s)->S + 2 * (i) : (s)->vfp_dh + 2 * ((i) - 16))
+
+static inline double gliss_vfp_load_d(const float *r) {
+	double d;
+	memcpy(&d, r, sizeof(d));
+	return d;
+}
+
+static inline void gliss_vfp_store_d(float *r, double d) {
+	memcpy(r, &d, sizeof(d));
+}
+
+static inline uint64_t gliss_vfp_load_d_bits(const float *r) {
+	uint64_t b;
+	memcpy(&b, r, sizeof(b));
+	return b;
+}
+
+static inline void gliss_vfp_store_d_bits(float *r, uint64_t b) {
+	memcpy(r, &b, sizeof(b));
+}
+
+static inline float gliss_vfp_dn32(int dn, float x) {
+	if(x != x && dn) {
+		uint32_t n = 0x7fc00000;
+		memcpy(&x, &n, sizeof(x));
+	}
+	return x;
+}
+
+static inline double gliss_vfp_dn64(int dn, double x) {
+	if(x != x && dn) {
+		uint64_t n = 0x7ff8000000000000ULL;
+		memcpy(&x, &n, sizeof(x));
+	}
+	return x;
+}
+
+/* accessors used by the execution code (state is in scope) */
+#define gliss_vfp_d(i)				gliss_vfp_load_d(GLISS_VFP_DREG(state, i))
+#define gliss_vfp_set_d(i, v)		gliss_vfp_store_d(GLISS_VFP_DREG(state, i), (v))
+#define gliss_vfp_d_bits(i)			gliss_vfp_load_d_bits(GLISS_VFP_DREG(state, i))
+#define gliss_vfp_set_d_bits(i, b)	gliss_vfp_store_d_bits(GLISS_VFP_DREG(state, i), (b))
+
+/* FPSCR and arithmetic helpers */
+#define gliss_vfp_fpscr_write(v)		gliss_vfp_set_fpscr(state, (v))
+#define gliss_vfp_fpscr_read(v)			gliss_vfp_get_fpscr(v)
+#define gliss_vfp_res32(x)				gliss_vfp_dn32(state->vfp_dn, (x))
+#define gliss_vfp_res64(x)				gliss_vfp_dn64(state->vfp_dn, (x))
+#define gliss_vfp_sqrt32(x)				gliss_vfp_dn32(state->vfp_dn, (float)gliss_vfp_sqrt(x))
+#define gliss_vfp_sqrt64(x)				gliss_vfp_dn64(state->vfp_dn, gliss_vfp_sqrt(x))
+#define gliss_vfp_to_fixed(x, u, z)		gliss_vfp_to_int((x), (u), (z))
+#define gliss_vfp_cmp(x, y, e)			gliss_vfp_compare((x), (y), (e))
+#define gliss_vfp_cmp32(x, y, e)		gliss_vfp_compare32((x), (y), (e))
+
+void gliss_vfp_init(struct gliss_state_t *state);
+void gliss_vfp_set_fpscr(struct gliss_state_t *state, uint32_t fpscr);
+uint32_t gliss_vfp_get_fpscr(uint32_t fpscr);
+double gliss_vfp_sqrt(double x);
+uint32_t gliss_vfp_to_int(double x, int is_unsigned, int round_zero);
+uint32_t gliss_vfp_compare(double x, double y, int e);
+uint32_t gliss_vfp_compare32(float x, float y, int e);
+
+/* Advanced SIMD operations (d, n, m are D register numbers, r the number of
+ * D registers, 1 for D forms and 2 for Q forms; the functions take the
+ * address of the registers as a Q register never spans S and vfp_dh) */
+#define GLISS_SIMD_ADD		0
+#define GLISS_SIMD_SUB		1
+#define GLISS_SIMD_MUL		2
+#define GLISS_SIMD_MLA		3
+#define GLISS_SIMD_MLS		4
+#define GLISS_SIMD_MAX		5
+#define GLISS_SIMD_MIN		6
+#define GLISS_SIMD_AND		0
+#define GLISS_SIMD_ORR		1
+#define GLISS_SIMD_EOR		2
+
+#define gliss_simd_f32(o, d, n, m, r) \
+	gliss_vfp_simd_f32((o), GLISS_VFP_DREG(state, d), GLISS_VFP_DREG(state, n), GLISS_VFP_DREG(state, m), (r))
+#define gliss_simd_int(o, z, d, n, m, r) \
+	gliss_vfp_simd_int((o), (z), GLISS_VFP_DREG(state, d), GLISS_VFP_DREG(state, n), GLISS_VFP_DREG(state, m), (r))
+#define gliss_simd_bits(o, d, n, m, r) \
+	gliss_vfp_simd_bits((o), GLISS_VFP_DREG(state, d), GLISS_VFP_DREG(state, n), GLISS_VFP_DREG(state, m), (r))
+#define gliss_simd_dup(z, d, v, r) \
+	gliss_vfp_simd_dup((z), GLISS_VFP_DREG(state, d), (v), (r))
+
+void gliss_vfp_simd_f32(int op, float *d, const float *n, const float *m, int regs);
+void gliss_vfp_simd_int(int op, int size, float *d, const float *n, const float *m, int regs);
+void gliss_vfp_simd_bits(int op, float *d, const float *n, const float *m, int regs);
+void gliss_vfp_simd_dup(int size, float *d, uint32_t v, int regs);
+
+/* accessors for external tools */
+double gliss_vfp_get_double(struct gliss_state_t *state, int i);
+void gliss_vfp_set_double(struct gliss_state_t *state, int i, double v);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* GLISS_VFP_H */
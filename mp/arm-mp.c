@@ -0,0 +1,272 @@
+/*
+ * ARMv7T -- multi-core simulator
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Runs N cores (states) sharing the memory of one platform, each core on
+ * its own host thread. Core 0 starts at the entry point of the executable
+ * as a single-core simulator would; the other cores call the entry symbol
+ * (default mp_secondary) with their number in r0 and their own stack below
+ * the one of core 0, and stop when this function returns. If the executable
+ * defines a word mp_cores, it is set to the number of cores before starting.
+ *
+ * The cores are either free-running or scheduled in round-robin, one
+ * quantum of instructions at a time. The exclusive accesses, the plain
+ * stores and the barriers are performed on the host (see extern/excl.h).
+ *
+ * The pages of the memory are allocated on first access and this allocation
+ * is not thread-safe: the stacks, the data and BSS sections (from __data_start
+ * or __bss_start__ to end) and the range given by -p are allocated before
+ * the cores are started. Shared data outside these ranges (heap) must be
+ * written by core 0 before the other cores use it.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arm/api.h>
+#include <arm/loader.h>
+#include <arm/mem.h>
+
+#define MAX_CORES	64
+#define PAGE		4096
+
+/* options */
+int core_cnt = 1;
+int quantum = 0;
+uint32_t stack_size = 64 << 10;
+const char *entry_name = "mp_secondary";
+uint32_t pre_lo = 0, pre_hi = 0;
+
+/* cores */
+typedef struct core_t {
+	int id;
+	arm_state_t *state;
+	arm_sim_t *sim;
+	pthread_t thread;
+	atomic_int alive;
+} core_t;
+core_t cores[MAX_CORES];
+atomic_int turn = 0;
+
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: arm-mp [-n CORES] [-q QUANTUM] [-s STACK] [-e ENTRY] [-p LO-HI] EXECUTABLE\n"
+		"\t-n CORES\tnumber of cores (default 1)\n"
+		"\t-q QUANTUM\tround-robin with QUANTUM instructions per core (default 0, free-running)\n"
+		"\t-s STACK\tstack size of each core (default 64K)\n"
+		"\t-e ENTRY\tentry function of the secondary cores (default mp_secondary)\n"
+		"\t-p LO-HI\tallocate the memory from LO to HI before starting\n");
+}
+
+
+/**
+ * Allocate the pages of a memory range by writing them.
+ * @param mem	Memory.
+ * @param lo	First address.
+ * @param hi	Last address (excluded).
+ */
+void prefault(arm_memory_t *mem, uint32_t lo, uint32_t hi) {
+	uint32_t a;
+	for(a = lo & ~(PAGE - 1); a < hi; a += PAGE)
+		arm_mem_write8(mem, a, arm_mem_read8(mem, a));
+}
+
+
+/**
+ * Pass the turn to the next alive core after the given one.
+ * @param id	Current core.
+ */
+void pass_turn(int id) {
+	int i, n;
+	for(i = 1; i <= core_cnt; i++) {
+		n = (id + i) % core_cnt;
+		if(atomic_load(&cores[n].alive)) {
+			atomic_store(&turn, n);
+			return;
+		}
+	}
+}
+
+
+/**
+ * Run a core until its end.
+ * @param arg	Core.
+ * @return		NULL.
+ */
+void *run(void *arg) {
+	core_t *core = (core_t *)arg;
+	int i;
+
+	/* free-running */
+	if(quantum == 0)
+		while(!arm_is_sim_ended(core->sim))
+			arm_step(core->sim);
+
+	/* round-robin */
+	else
+		while(1) {
+			while(atomic_load(&turn) != core->id)
+				sched_yield();
+			for(i = 0; i < quantum && !arm_is_sim_ended(core->sim); i++)
+				arm_step(core->sim);
+			if(arm_is_sim_ended(core->sim)) {
+				atomic_store(&core->alive, 0);
+				pass_turn(core->id);
+				break;
+			}
+			pass_turn(core->id);
+		}
+
+	return NULL;
+}
+
+
+/**
+ * Command entry point.
+ */
+int main(int argc, char **argv) {
+	arm_platform_t *pf;
+	arm_loader_t *loader;
+	arm_memory_t *mem;
+	arm_address_t exit_addr = 0, entry = 0, cores_addr = 0;
+	arm_address_t data_lo = 0, data_hi = 0;
+	uint32_t sp;
+	int opt, i, cnt;
+	char *p;
+
+	/* parse arguments */
+	while((opt = getopt(argc, argv, "n:q:s:e:p:h")) != -1)
+		switch(opt) {
+		case 'n':	core_cnt = atoi(optarg); break;
+		case 'q':	quantum = atoi(optarg); break;
+		case 's':
+			stack_size = strtoul(optarg, &p, 0);
+			if(*p == 'K' || *p == 'k')
+				stack_size <<= 10;
+			else if(*p == 'M' || *p == 'm')
+				stack_size <<= 20;
+			break;
+		case 'e':	entry_name = optarg; break;
+		case 'p':
+			pre_lo = strtoul(optarg, &p, 0);
+			if(*p != '-') {
+				usage();
+				return 1;
+			}
+			pre_hi = strtoul(p + 1, NULL, 0);
+			break;
+		default:	usage(); return 1;
+		}
+	if(optind + 1 != argc || core_cnt < 1 || core_cnt > MAX_CORES || quantum < 0) {
+		usage();
+		return 1;
+	}
+
+	/* load the executable */
+	pf = arm_new_platform();
+	if(pf == NULL) {
+		fprintf(stderr, "ERROR: no more resources\n");
+		return 2;
+	}
+	loader = arm_loader_open(argv[optind]);
+	if(loader == NULL) {
+		fprintf(stderr, "ERROR: cannot load the executable \"%s\"\n", argv[optind]);
+		return 2;
+	}
+	arm_load(pf, loader);
+	cnt = arm_loader_count_syms(loader);
+	for(i = 0; i < cnt; i++) {
+		arm_loader_sym_t sym;
+		arm_loader_sym(loader, i, &sym);
+		if(strcmp(sym.name, "_exit") == 0)
+			exit_addr = sym.value;
+		else if(strcmp(sym.name, entry_name) == 0)
+			entry = sym.value;
+		else if(strcmp(sym.name, "mp_cores") == 0)
+			cores_addr = sym.value;
+		else if(strcmp(sym.name, "__data_start") == 0
+		|| (strcmp(sym.name, "__bss_start__") == 0 && data_lo == 0))
+			data_lo = sym.value;
+		else if(strcmp(sym.name, "end") == 0)
+			data_hi = sym.value;
+	}
+	arm_loader_close(loader);
+	if(core_cnt > 1 && entry == 0) {
+		fprintf(stderr, "ERROR: no entry %s for the secondary cores\n", entry_name);
+		return 2;
+	}
+
+	/* build the cores */
+	for(i = 0; i < core_cnt; i++) {
+		cores[i].id = i;
+		cores[i].state = arm_new_state(pf);
+		if(cores[i].state == NULL) {
+			fprintf(stderr, "ERROR: no more resources\n");
+			return 2;
+		}
+		cores[i].sim = arm_new_sim(cores[i].state, 0, exit_addr);
+		if(cores[i].sim == NULL) {
+			fprintf(stderr, "ERROR: no more resources\n");
+			return 2;
+		}
+		atomic_init(&cores[i].alive, 1);
+	}
+	sp = cores[0].state->GPR[13];
+	for(i = 1; i < core_cnt; i++) {
+		arm_state_t *s = cores[i].state;
+		s->GPR[0] = i;
+		s->GPR[13] = sp - i * stack_size;
+		s->GPR[14] = exit_addr | (entry & 1);
+		s->GPR[15] = entry & ~1;
+		if(entry & 1)
+			s->APSR |= 1 << 5;
+	}
+
+	/* allocate the shared pages */
+	mem = arm_get_memory(pf, ARM_MAIN_MEMORY);
+	prefault(mem, sp - core_cnt * stack_size, sp);
+	if(data_lo != 0 && data_hi > data_lo)
+		prefault(mem, data_lo, data_hi);
+	if(pre_hi > pre_lo)
+		prefault(mem, pre_lo, pre_hi);
+	if(cores_addr != 0)
+		arm_mem_write32(mem, cores_addr, core_cnt);
+
+	/* run the cores */
+	for(i = 0; i < core_cnt; i++)
+		if(pthread_create(&cores[i].thread, NULL, run, &cores[i]) != 0) {
+			fprintf(stderr, "ERROR: cannot create the thread of core %d\n", i);
+			return 2;
+		}
+	for(i = 0; i < core_cnt; i++)
+		pthread_join(cores[i].thread, NULL);
+
+	/* cleanup */
+	for(i = 0; i < core_cnt; i++)
+		arm_delete_sim(cores[i].sim);
+	arm_unlock_platform(pf);
+	return 0;
+}
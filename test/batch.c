@@ -0,0 +1,38 @@
+/*
+ * Guest program of the batch test: computes the CRC-32 of its input and
+ * returns its low byte. The input is read from batch_input when filled by
+ * arm-batch (batch_input_size set), else from the standard input.
+ *
+ * Build and run with "make batch-bench" in this directory: the program is
+ * compiled as ARM code and run on BATCH_K random inputs, once by arm-sim per
+ * input and twice by arm-batch for all of them (with and without the vector
+ * execution), and the exit codes are compared.
+ */
+
+#include <stdint.h>
+#include <unistd.h>
+
+#define INPUT_MAX	4096
+
+/* filled by arm-batch: initialized so that they are in .data, crt0 clearing
+ * the .bss after the loading (NO_INPUT: not filled) */
+#define NO_INPUT	0xffffffff
+char batch_input[INPUT_MAX] = { 1 };
+volatile uint32_t batch_input_size = NO_INPUT;
+
+int main(void) {
+	uint32_t crc = 0xffffffff, n = batch_input_size, i;
+	int j;
+
+	if(n == NO_INPUT)
+		n = read(0, batch_input, INPUT_MAX);
+	for(i = 0; i < n; i++) {
+		crc ^= (uint8_t)batch_input[i];
+		for(j = 0; j < 8; j++)
+			if(crc & 1)
+				crc = (crc >> 1) ^ 0xedb88320;
+			else
+				crc >>= 1;
+	}
+	return ~crc & 0xff;
+}
@@ -0,0 +1,66 @@
+/*
+ * Guest program of the profile test: a fixed integer workload (CRC-32,
+ * prime sieve and insertion sort) without input and output.
+ *
+ * Build and run with "make profile-bench" in this directory: the simulator
+ * is rebuilt with and without WITH_M_PROFILE and the code size and the
+ * speed (MIPS) of both builds are displayed.
+ */
+
+#include <stdint.h>
+
+#define SIZE	8192
+#define ROUNDS	16
+
+static uint8_t buf[SIZE];
+static int vals[1024];
+
+static uint32_t crc32(const uint8_t *p, int n) {
+	uint32_t crc = 0xffffffff;
+	int i, j;
+	for(i = 0; i < n; i++) {
+		crc ^= p[i];
+		for(j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+static int sieve(uint8_t *p, int n) {
+	int i, j, c = 0;
+	for(i = 0; i < n; i++)
+		p[i] = 1;
+	for(i = 2; i < n; i++)
+		if(p[i]) {
+			c++;
+			for(j = 2 * i; j < n; j += i)
+				p[j] = 0;
+		}
+	return c;
+}
+
+static void sort(int *v, int n) {
+	int i, j, x;
+	for(i = 1; i < n; i++) {
+		x = v[i];
+		for(j = i - 1; j >= 0 && v[j] > x; j--)
+			v[j + 1] = v[j];
+		v[j + 1] = x;
+	}
+}
+
+int main(void) {
+	uint32_t r = 0, x = 1;
+	int i, k;
+	for(k = 0; k < ROUNDS; k++) {
+		r += sieve(buf, SIZE);
+		r ^= crc32(buf, SIZE);
+		for(i = 0; i < 1024; i++) {
+			x = x * 1103515245 + 12345;
+			vals[i] = x >> 8;
+		}
+		sort(vals, 1024);
+		r += vals[k];
+	}
+	return r == 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Guest program of the exception check benchmark: a 64-bit atomic counter
+ * (LDREXD/STREXD, alignment checked) incremented COUNT times with one
+ * semihosting call (SVC 0x123456) every 256 iterations.
+ *
+ * Build and run with "make exn-bench" in this directory: the simulator is
+ * rebuilt for each exception mode (EXN = none, out, in) and timed on it.
+ */
+
+#include <stdint.h>
+
+#define COUNT		10000000
+#define SYS_ISERROR	0x08
+
+static volatile uint64_t counter;
+static uint32_t block[1];
+
+int main(void) {
+	int i;
+	for(i = 0; i < COUNT; i++) {
+		__atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+		if((i & 0xff) == 0) {
+			register uint32_t r0 __asm__("r0") = SYS_ISERROR;
+			register uint32_t *r1 __asm__("r1") = block;
+			__asm__ volatile("svc 0x123456" : "+r"(r0) : "r"(r1) : "memory");
+		}
+	}
+	return counter != COUNT;
+}
@@ -0,0 +1,132 @@
+/*
+ * Guest program of the multi-core test: each core increments a counter
+ * protected by a spin lock and pushes and pops values through a bounded
+ * lock-free queue (multiple producers and consumers), both built on
+ * LDREX/STREX and DMB.
+ *
+ * Build and run with "make mp-bench" in this directory: the program is run
+ * by ../mp/arm-mp on 1 to 16 cores and checks the counter and the sum of
+ * the popped values.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LOCK_ITER	10000
+#define QUEUE_ITER	10000
+#define QUEUE_SIZE	64			/* power of 2 */
+
+/* set by arm-mp */
+volatile int mp_cores = 1;
+
+static volatile int start, done;
+
+/* spin lock */
+static int lock;
+static volatile unsigned counter;
+
+static void acquire(int *l) {
+	while(__atomic_exchange_n(l, 1, __ATOMIC_ACQUIRE))
+		while(__atomic_load_n(l, __ATOMIC_RELAXED))
+			;
+}
+
+static void release(int *l) {
+	__atomic_store_n(l, 0, __ATOMIC_RELEASE);
+}
+
+/* bounded MPMC queue (D. Vyukov) */
+static struct {
+	unsigned seq;
+	uint32_t val;
+} cells[QUEUE_SIZE];
+static unsigned head, tail;
+static uint64_t sums[16];
+
+static int push(uint32_t v) {
+	unsigned pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+	while(1) {
+		unsigned seq = __atomic_load_n(&cells[pos % QUEUE_SIZE].seq, __ATOMIC_ACQUIRE);
+		int d = (int)(seq - pos);
+		if(d == 0) {
+			if(__atomic_compare_exchange_n(&tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		else if(d < 0)
+			return 0;
+		else
+			pos = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+	}
+	cells[pos % QUEUE_SIZE].val = v;
+	__atomic_store_n(&cells[pos % QUEUE_SIZE].seq, pos + 1, __ATOMIC_RELEASE);
+	return 1;
+}
+
+static int pop(uint32_t *v) {
+	unsigned pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+	while(1) {
+		unsigned seq = __atomic_load_n(&cells[pos % QUEUE_SIZE].seq, __ATOMIC_ACQUIRE);
+		int d = (int)(seq - (pos + 1));
+		if(d == 0) {
+			if(__atomic_compare_exchange_n(&head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		}
+		else if(d < 0)
+			return 0;
+		else
+			pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+	}
+	*v = cells[pos % QUEUE_SIZE].val;
+	__atomic_store_n(&cells[pos % QUEUE_SIZE].seq, pos + QUEUE_SIZE, __ATOMIC_RELEASE);
+	return 1;
+}
+
+/* work of one core */
+static void work(int id) {
+	uint32_t v;
+	uint64_t s = 0;
+	int i, n;
+
+	for(i = 0; i < LOCK_ITER; i++) {
+		acquire(&lock);
+		counter++;
+		release(&lock);
+	}
+
+	for(i = 0, n = 0; i < QUEUE_ITER || n < QUEUE_ITER; ) {
+		if(i < QUEUE_ITER && push(id * QUEUE_ITER + i))
+			i++;
+		if(n < QUEUE_ITER && pop(&v)) {
+			s += v;
+			n++;
+		}
+	}
+	sums[id] = s;
+
+	__atomic_add_fetch(&done, 1, __ATOMIC_RELEASE);
+}
+
+void mp_secondary(int id) {
+	while(!__atomic_load_n(&start, __ATOMIC_ACQUIRE))
+		;
+	work(id);
+}
+
+int main(void) {
+	uint64_t s = 0, e;
+	int i, n = mp_cores;
+
+	for(i = 0; i < QUEUE_SIZE; i++)
+		cells[i].seq = i;
+	__atomic_store_n(&start, 1, __ATOMIC_RELEASE);
+	work(0);
+	while(__atomic_load_n(&done, __ATOMIC_ACQUIRE) != n)
+		;
+
+	for(i = 0; i < n; i++)
+		s += sums[i];
+	e = (uint64_t)n * QUEUE_ITER;
+	e = e * (e - 1) / 2;
+	printf("%d cores: counter %u, queue sum %llu\n", n, counter, (unsigned long long)s);
+	return counter != (unsigned)n * LOCK_ITER || s != e;
+}
@@ -0,0 +1,19 @@
+/*
+ * Guest program of the I/O throughput test: copies its standard input to
+ * its standard output through read() and write() (newlib semihosting).
+ *
+ * Build and run with "make stream-bench" in this directory: a 100 MB file
+ * is streamed through the simulator and the output compared with the input.
+ */
+
+#include <unistd.h>
+
+static char buf[16 * 1024];
+
+int main(void) {
+	int n;
+	while((n = read(0, buf, sizeof(buf))) > 0)
+		if(write(1, buf, n) != n)
+			return 1;
+	return n < 0;
+}
@@ -0,0 +1,444 @@
+/*
+ * Check of the host-FPU VFP path (extern/vfp.c) against a bit-level
+ * soft-float reference of the ARM single-precision arithmetic, and
+ * differential benchmark of both.
+ *
+ * For each rounding mode, VADD, VSUB, VMUL, VDIV, VCMP/VCMPE and VCVT to
+ * integer are applied to special values and random operands as the simulator
+ * does (FPSCR installed with arm_vfp_set_fpscr(), host operation, flags
+ * collected with arm_vfp_get_fpscr()) and compared with the reference: result
+ * bits (any NaN matches any NaN) and cumulative flags IOC, DZC, OFC, UFC and
+ * IXC. Flush-to-zero is not checked.
+ *
+ * The ARM detects tininess before rounding while x86 hosts detect it after
+ * rounding: results rounded up to the smallest normal number have UFC on the
+ * ARM only. These are counted apart ("tininess") and are not failures.
+ *
+ * Build and run with "make vfp-bench" in this directory.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <arm/api.h>
+#include <arm/vfp.h>
+
+#define RANDOM	200000
+#define COUNT	20000000
+
+#define IOC		0x01
+#define DZC		0x02
+#define OFC		0x04
+#define UFC		0x08
+#define IXC		0x10
+#define FLAGS	0x1f
+
+enum { ADD, SUB, MUL, DIV, CMP, CMPE, CVTS, CVTU, CVTSZ, CVTUZ, OPS };
+static const char *names[OPS] = {
+	"vadd.f32", "vsub.f32", "vmul.f32", "vdiv.f32", "vcmp.f32", "vcmpe.f32",
+	"vcvtr.s32.f32", "vcvtr.u32.f32", "vcvt.s32.f32", "vcvt.u32.f32"
+};
+static const char *modes[4] = { "RN", "RP", "RM", "RZ" };
+
+
+/****** soft-float reference ******/
+
+#define SIGN(b)		((b) >> 31)
+#define EXP(b)		(((b) >> 23) & 0xff)
+#define FRAC(b)		((b) & 0x7fffff)
+#define ISNAN(b)	(EXP(b) == 0xff && FRAC(b) != 0)
+#define ISSNAN(b)	(ISNAN(b) && ((b) & 0x400000) == 0)
+#define ISINF(b)	(EXP(b) == 0xff && FRAC(b) == 0)
+#define ISZERO(b)	(((b) & 0x7fffffff) == 0)
+#define QNAN		0x7fc00000
+#define INF			0x7f800000
+
+/* value of a finite non-zero number is m * 2^e */
+static void unpack(uint32_t b, uint64_t *m, int *e) {
+	if(EXP(b) == 0) {
+		*m = FRAC(b);
+		*e = -149;
+	}
+	else {
+		*m = FRAC(b) | 0x800000;
+		*e = EXP(b) - 150;
+	}
+}
+
+/* round sign * m * 2^e (m != 0, bit 0 of m may be a sticky bit) */
+static uint32_t round32(int sign, uint64_t m, int e, int rmode, int *flags) {
+	int top = 63, shift, E, inc;
+	uint64_t q, rem, half;
+	int guard, rest;
+
+	while(!(m >> top))
+		top--;
+	E = e + top;
+	shift = E >= -126 ? top - 23 : top - 23 + (-126 - E);
+	if(shift <= 0) {
+		q = m << -shift;
+		guard = rest = 0;
+	}
+	else if(shift > 64) {
+		q = 0;
+		guard = 0;
+		rest = 1;
+	}
+	else {
+		q = shift == 64 ? 0 : m >> shift;
+		rem = shift == 64 ? m : m & ((1ULL << shift) - 1);
+		half = 1ULL << (shift - 1);
+		guard = (rem & half) != 0;
+		rest = (rem & (half - 1)) != 0;
+	}
+	switch(rmode) {
+	case 0:		inc = guard && (rest || (q & 1)); break;
+	case 1:		inc = !sign && (guard || rest); break;
+	case 2:		inc = sign && (guard || rest); break;
+	default:	inc = 0; break;
+	}
+	if(guard || rest)
+		*flags |= IXC;
+	q += inc;
+
+	/* subnormal (ARM tininess before rounding) */
+	if(E < -126) {
+		if(guard || rest)
+			*flags |= UFC;
+		return (sign << 31) | (uint32_t)q;
+	}
+
+	/* normal */
+	if(q >> 24) {
+		q >>= 1;
+		E++;
+	}
+	if(E > 127) {
+		*flags |= OFC | IXC;
+		if(rmode == 3 || (rmode == 1 && sign) || (rmode == 2 && !sign))
+			return (sign << 31) | 0x7f7fffff;
+		else
+			return (sign << 31) | INF;
+	}
+	return (sign << 31) | ((uint32_t)(E + 127) << 23) | (uint32_t)(q & 0x7fffff);
+}
+
+static int nan_flags(uint32_t a, uint32_t b) {
+	return ISSNAN(a) || ISSNAN(b) ? IOC : 0;
+}
+
+static uint32_t ref_add(uint32_t a, uint32_t b, int rmode, int *flags) {
+	uint64_t ma, mb, m;
+	int ea, eb, sa = SIGN(a), sb = SIGN(b), s, d;
+
+	if(ISNAN(a) || ISNAN(b)) {
+		*flags |= nan_flags(a, b);
+		return QNAN;
+	}
+	if(ISINF(a) || ISINF(b)) {
+		if(ISINF(a) && ISINF(b) && sa != sb) {
+			*flags |= IOC;
+			return QNAN;
+		}
+		return ISINF(a) ? a : b;
+	}
+	if(ISZERO(a) && ISZERO(b))
+		return sa == sb ? a : (rmode == 2 ? 0x80000000 : 0);
+	if(ISZERO(a))
+		return b;
+	if(ISZERO(b))
+		return a;
+
+	unpack(a, &ma, &ea);
+	unpack(b, &mb, &eb);
+	if(ea < eb || (ea == eb && ma < mb)) {
+		uint64_t tm = ma; int te = ea, ts = sa;
+		ma = mb; ea = eb; sa = sb;
+		mb = tm; eb = te; sb = ts;
+	}
+	/* 38 guard bits, the lost bits of b are jammed in bit 0 */
+	ma <<= 38;
+	mb <<= 38;
+	d = ea - eb;
+	if(d >= 64)
+		mb = 1;
+	else if(d > 0)
+		mb = (mb >> d) | ((mb & ((1ULL << d) - 1)) != 0);
+	s = sa;
+	m = sa == sb ? ma + mb : ma - mb;
+	if(m == 0)
+		return rmode == 2 ? 0x80000000 : 0;
+	return round32(s, m, ea - 38, rmode, flags);
+}
+
+static uint32_t ref_mul(uint32_t a, uint32_t b, int rmode, int *flags) {
+	uint64_t ma, mb;
+	int ea, eb, s = SIGN(a) ^ SIGN(b);
+
+	if(ISNAN(a) || ISNAN(b)) {
+		*flags |= nan_flags(a, b);
+		return QNAN;
+	}
+	if((ISINF(a) && ISZERO(b)) || (ISZERO(a) && ISINF(b))) {
+		*flags |= IOC;
+		return QNAN;
+	}
+	if(ISINF(a) || ISINF(b))
+		return (s << 31) | INF;
+	if(ISZERO(a) || ISZERO(b))
+		return s << 31;
+	unpack(a, &ma, &ea);
+	unpack(b, &mb, &eb);
+	return round32(s, ma * mb, ea + eb, rmode, flags);
+}
+
+static uint32_t ref_div(uint32_t a, uint32_t b, int rmode, int *flags) {
+	uint64_t ma, mb, q;
+	int ea, eb, s = SIGN(a) ^ SIGN(b);
+
+	if(ISNAN(a) || ISNAN(b)) {
+		*flags |= nan_flags(a, b);
+		return QNAN;
+	}
+	if((ISINF(a) && ISINF(b)) || (ISZERO(a) && ISZERO(b))) {
+		*flags |= IOC;
+		return QNAN;
+	}
+	if(ISINF(a) || ISZERO(b)) {
+		if(ISZERO(b) && !ISINF(a))
+			*flags |= DZC;
+		return (s << 31) | INF;
+	}
+	if(ISZERO(a) || ISINF(b))
+		return s << 31;
+	unpack(a, &ma, &ea);
+	unpack(b, &mb, &eb);
+	while(!(ma & 0x800000)) {
+		ma <<= 1;
+		ea--;
+	}
+	while(!(mb & 0x800000)) {
+		mb <<= 1;
+		eb--;
+	}
+	q = (ma << 40) / mb;
+	q = (q << 1) | ((ma << 40) % mb != 0);
+	return round32(s, q, ea - eb - 41, rmode, flags);
+}
+
+static uint32_t ref_cmp(uint32_t a, uint32_t b, int e, int *flags) {
+	int64_t x, y;
+	if(ISNAN(a) || ISNAN(b)) {
+		if(e || ISSNAN(a) || ISSNAN(b))
+			*flags |= IOC;
+		return 0x3;
+	}
+	x = SIGN(a) ? -(int64_t)(a & 0x7fffffff) : (int64_t)(a & 0x7fffffff);
+	y = SIGN(b) ? -(int64_t)(b & 0x7fffffff) : (int64_t)(b & 0x7fffffff);
+	if(x == y)
+		return 0x6;
+	else if(x < y)
+		return 0x8;
+	else
+		return 0x2;
+}
+
+static uint32_t ref_cvt(uint32_t a, int is_unsigned, int rmode, int *flags) {
+	int64_t min = is_unsigned ? 0 : -2147483648LL;
+	int64_t max = is_unsigned ? 4294967295LL : 2147483647LL;
+	uint64_t m, q;
+	int e, sign = SIGN(a), inexact = 0, inc = 0;
+	int64_t r;
+
+	if(ISNAN(a)) {
+		*flags |= IOC;
+		return 0;
+	}
+	if(ISINF(a)) {
+		*flags |= IOC;
+		return sign ? (uint32_t)min : (uint32_t)max;
+	}
+	if(ISZERO(a))
+		return 0;
+	unpack(a, &m, &e);
+	if(e >= 0)
+		q = e >= 40 ? 1ULL << 40 : m << e;
+	else if(e <= -64) {
+		q = 0;
+		inexact = 1;
+		inc = (rmode == 1 && !sign) || (rmode == 2 && sign);
+	}
+	else {
+		uint64_t rem = m & ((1ULL << -e) - 1), half = 1ULL << (-e - 1);
+		q = m >> -e;
+		inexact = rem != 0;
+		switch(rmode) {
+		case 0:		inc = rem > half || (rem == half && (q & 1)); break;
+		case 1:		inc = !sign && inexact; break;
+		case 2:		inc = sign && inexact; break;
+		default:	inc = 0; break;
+		}
+	}
+	q += inc;
+	r = sign ? -(int64_t)q : (int64_t)q;
+	if(r < min || r > max) {
+		*flags |= IOC;
+		return r < min ? (uint32_t)min : (uint32_t)max;
+	}
+	if(inexact)
+		*flags |= IXC;
+	return (uint32_t)r;
+}
+
+static uint32_t ref(int op, uint32_t a, uint32_t b, int rmode, int *flags) {
+	switch(op) {
+	case ADD:	return ref_add(a, b, rmode, flags);
+	case SUB:	return ref_add(a, b ^ 0x80000000, rmode, flags);
+	case MUL:	return ref_mul(a, b, rmode, flags);
+	case DIV:	return ref_div(a, b, rmode, flags);
+	case CMP:	return ref_cmp(a, b, 0, flags);
+	case CMPE:	return ref_cmp(a, b, 1, flags);
+	case CVTS:	return ref_cvt(a, 0, rmode, flags);
+	case CVTU:	return ref_cvt(a, 1, rmode, flags);
+	case CVTSZ:	return ref_cvt(a, 0, 3, flags);
+	default:	return ref_cvt(a, 1, 3, flags);
+	}
+}
+
+
+/****** simulator path ******/
+
+static uint32_t bits(float x) {
+	uint32_t b;
+	memcpy(&b, &x, sizeof(b));
+	return b;
+}
+
+static float value(uint32_t b) {
+	float x;
+	memcpy(&x, &b, sizeof(x));
+	return x;
+}
+
+static uint32_t host(int op, uint32_t a, uint32_t b) {
+	volatile float x = value(a), y = value(b);
+	switch(op) {
+	case ADD:	return bits(x + y);
+	case SUB:	return bits(x - y);
+	case MUL:	return bits(x * y);
+	case DIV:	return bits(x / y);
+	case CMP:	return arm_vfp_compare32(x, y, 0);
+	case CMPE:	return arm_vfp_compare32(x, y, 1);
+	case CVTS:	return arm_vfp_to_int(x, 0, 0);
+	case CVTU:	return arm_vfp_to_int(x, 1, 0);
+	case CVTSZ:	return arm_vfp_to_int(x, 0, 1);
+	default:	return arm_vfp_to_int(x, 1, 1);
+	}
+}
+
+
+/****** operands ******/
+
+static const uint32_t specials[] = {
+	0x00000000, 0x80000000, 0x00000001, 0x807fffff, 0x00800000, 0x80800001,
+	0x3f800000, 0xbf800000, 0x3fc00000, 0x40200000, 0x4f000000, 0xcf000000,
+	0x4f800000, 0x4effffff, 0x7f7fffff, 0xff7fffff, 0x7f800000, 0xff800000,
+	0x7fc00000, 0xffc00001, 0x7f800001, 0xffa00000, 0x34000000, 0x33800000,
+	0x3f7fffff, 0xbf7fffff, 0x007fffff, 0x3f800001
+};
+#define SPECIALS	(sizeof(specials) / sizeof(specials[0]))
+
+static uint32_t seed = 0x12345678;
+static uint32_t rnd(void) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+/* random operand, with b close to a one time in four to exercise the
+ * cancellations and the rounding of near-halfway cases */
+static void operands(int i, uint32_t *a, uint32_t *b) {
+	if(i < (int)(SPECIALS * SPECIALS)) {
+		*a = specials[i / SPECIALS];
+		*b = specials[i % SPECIALS];
+		return;
+	}
+	*a = rnd();
+	*b = rnd();
+	if((*b & 3) == 0)
+		*b = (*a & 0xff800000) | (*b >> 9);
+}
+
+
+int main(void) {
+	arm_platform_t *pf = arm_new_platform();
+	arm_state_t *state = arm_new_state(pf);
+	int op, rmode, i, fails = 0, tiny = 0;
+	struct timespec t0, t1;
+	double th, tr;
+	uint32_t acc = 0;
+
+	/* check */
+	for(op = 0; op < OPS; op++) {
+		int f = 0, t = 0;
+		for(rmode = 0; rmode < 4; rmode++) {
+			seed = 0x12345678;
+			for(i = 0; i < RANDOM; i++) {
+				uint32_t a, b, r, h;
+				int rf = 0, hf;
+				operands(i, &a, &b);
+				r = ref(op, a, b, rmode, &rf);
+				arm_vfp_set_fpscr(state, rmode << 22);
+				h = host(op, a, b);
+				hf = arm_vfp_get_fpscr(0) & FLAGS;
+				if((op <= DIV && ISNAN(r) && ISNAN(h)) || h == r) {
+					if(hf == rf)
+						continue;
+					if((hf ^ rf) == UFC && (h & 0x7fffffff) == 0x00800000) {
+						t++;
+						continue;
+					}
+				}
+				if(f < 5)
+					printf("FAILED: %s %s %08x, %08x: %08x (flags %02x) instead of %08x (flags %02x)\n",
+						names[op], modes[rmode], a, b, h, hf, r, rf);
+				f++;
+			}
+		}
+		printf("%-14s %8d checks, %d failed, %d tininess\n", names[op], 4 * RANDOM, f, t);
+		fails += f;
+		tiny += t;
+	}
+
+	/* differential benchmark: host path with lazy flags against the
+	 * reference called on each operation */
+	arm_vfp_set_fpscr(state, 0);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	{
+		volatile float x = 1.0f, y = 1.0000001f;
+		float s = 0;
+		for(i = 0; i < COUNT; i++)
+			s = s * y + x;
+		acc += bits(s) + arm_vfp_get_fpscr(0);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	th = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	{
+		uint32_t s = 0, x = bits(1.0f), y = bits(1.0000001f);
+		int flags = 0;
+		for(i = 0; i < COUNT; i++)
+			s = ref_add(ref_mul(s, y, 0, &flags), x, 0, &flags);
+		acc += s + flags;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	tr = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+	printf("vmla.f32: host %.2f ns, soft-float %.2f ns, speedup x%.1f (%08x)\n",
+		th / (2. * COUNT), tr / (2. * COUNT), tr / th, acc);
+
+	arm_delete_state(state);
+	arm_delete_platform(pf);
+	return fails != 0;
+}
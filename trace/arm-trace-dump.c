@@ -0,0 +1,80 @@
+/*
+ * ARMv7T -- trace dumper
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "reader.h"
+
+/**
+ * Display usage.
+ */
+void usage(void) {
+	fprintf(stderr, "SYNTAX: arm-trace-dump [-s] TRACE\n"
+		"\t-s\tonly display the event counts\n");
+}
+
+
+int main(int argc, char **argv) {
+	static const char *kinds[] = { "I", "R", "W", "?" };
+	arm_trace_reader_t *reader;
+	arm_trace_event_t event;
+	unsigned long long cnts[4] = { 0, 0, 0, 0 };
+	int summary = 0, res;
+	char *path = NULL;
+	int i;
+
+	/* parse arguments */
+	for(i = 1; i < argc; i++)
+		if(strcmp(argv[i], "-s") == 0)
+			summary = 1;
+		else if(argv[i][0] == '-') {
+			usage();
+			return 1;
+		}
+		else
+			path = argv[i];
+	if(path == NULL) {
+		usage();
+		return 1;
+	}
+
+	/* open the trace */
+	reader = arm_trace_open(path);
+	if(reader == NULL) {
+		fprintf(stderr, "ERROR: cannot open trace %s\n", path);
+		return 2;
+	}
+
+	/* dump the events */
+	while((res = arm_trace_next(reader, &event)) > 0) {
+		cnts[event.kind]++;
+		if(!summary)
+			printf("%s %08x %d\n", kinds[event.kind], event.addr, event.size);
+	}
+	arm_trace_close(reader);
+	if(res < 0) {
+		fprintf(stderr, "ERROR: corrupted trace %s\n", path);
+		return 3;
+	}
+
+	if(summary)
+		printf("instructions: %llu\nreads: %llu\nwrites: %llu\n",
+			cnts[ARM_TRACE_INST], cnts[ARM_TRACE_READ], cnts[ARM_TRACE_WRITE]);
+	return 0;
+}
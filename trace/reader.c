@@ -0,0 +1,137 @@
+/*
+ * ARMv7T -- trace reader
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "reader.h"
+
+#define HEADER_SIZE		8
+
+
+/**
+ * Open a trace file produced by WITH_TRACE.
+ * @param path	Path of the trace file.
+ * @return		Reader or NULL (errno is set).
+ */
+arm_trace_reader_t *arm_trace_open(const char *path) {
+	arm_trace_reader_t *r;
+	struct stat st;
+	void *base;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return NULL;
+	if(fstat(fd, &st) < 0 || st.st_size < HEADER_SIZE) {
+		close(fd);
+		return NULL;
+	}
+	base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED)
+		return NULL;
+	if(memcmp(base, ARM_TRACE_MAGIC, HEADER_SIZE) != 0) {
+		munmap(base, st.st_size);
+		return NULL;
+	}
+	madvise(base, st.st_size, MADV_SEQUENTIAL);
+
+	r = (arm_trace_reader_t *)malloc(sizeof(arm_trace_reader_t));
+	if(r == NULL) {
+		munmap(base, st.st_size);
+		return NULL;
+	}
+	r->base = (const uint8_t *)base;
+	r->size = st.st_size;
+	arm_trace_rewind(r);
+	return r;
+}
+
+
+/**
+ * Close a trace reader.
+ * @param reader	Reader to close.
+ */
+void arm_trace_close(arm_trace_reader_t *reader) {
+	munmap((void *)reader->base, reader->size);
+	free(reader);
+}
+
+
+/**
+ * Restart reading from the first event.
+ * @param reader	Reader to rewind.
+ */
+void arm_trace_rewind(arm_trace_reader_t *reader) {
+	reader->pos = HEADER_SIZE;
+	reader->next_pc = 0;
+	reader->last_addr = 0;
+}
+
+
+/**
+ * Read the next event.
+ * @param reader	Current reader.
+ * @param event		Filled with the read event.
+ * @return			1 if an event is read, 0 at end of trace, -1 if the trace is corrupted.
+ */
+int arm_trace_next(arm_trace_reader_t *reader, arm_trace_event_t *event) {
+	uint32_t z = 0, exp;
+	int shift = 0;
+	uint8_t tag, b;
+
+	if(reader->pos >= reader->size)
+		return 0;
+	tag = reader->base[reader->pos++];
+	event->kind = ARM_TRACE_KIND(tag);
+
+	/* sequential instruction */
+	if(event->kind == ARM_TRACE_INST) {
+		event->size = tag & ARM_TRACE_INST32 ? 4 : 2;
+		exp = reader->next_pc;
+		if(tag & ARM_TRACE_SEQ) {
+			event->addr = exp;
+			reader->next_pc = exp + event->size;
+			return 1;
+		}
+	}
+	else {
+		event->size = ARM_TRACE_SIZE(tag);
+		exp = reader->last_addr;
+	}
+
+	/* decode the delta */
+	do {
+		if(reader->pos >= reader->size || shift > 28)
+			return -1;
+		b = reader->base[reader->pos++];
+		z |= (uint32_t)(b & 0x7f) << shift;
+		shift += 7;
+	} while(b & 0x80);
+	event->addr = exp + ((z >> 1) ^ -(z & 1));
+
+	if(event->kind == ARM_TRACE_INST)
+		reader->next_pc = event->addr + event->size;
+	else
+		reader->last_addr = event->addr;
+	return 1;
+}
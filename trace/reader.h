@@ -0,0 +1,54 @@
+/*
+ * ARMv7T -- trace reader
+ * Copyright (C) 2011  IRIT - UPS
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ARM_TRACE_READER_H
+#define ARM_TRACE_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <arm/trace.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** Event read from a trace. */
+typedef struct arm_trace_event_t {
+	int kind;			/** ARM_TRACE_INST, ARM_TRACE_READ or ARM_TRACE_WRITE */
+	uint32_t addr;		/** instruction or accessed address */
+	int size;			/** instruction or access size (in bytes) */
+} arm_trace_event_t;
+
+/** Trace reader (memory-mapped trace file). */
+typedef struct arm_trace_reader_t {
+	const uint8_t *base;
+	size_t size;
+	size_t pos;
+	uint32_t next_pc;
+	uint32_t last_addr;
+} arm_trace_reader_t;
+
+arm_trace_reader_t *arm_trace_open(const char *path);
+void arm_trace_close(arm_trace_reader_t *reader);
+void arm_trace_rewind(arm_trace_reader_t *reader);
+int arm_trace_next(arm_trace_reader_t *reader, arm_trace_event_t *event);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* ARM_TRACE_READER_H */
@@ -65,15 +65,49 @@ reg_t registers[] = {
 	{ "lr", "R14", 32 },
 	{ "pc", "R15", 32 },
 	{ "cpsr", "APSR", 32, SR },
+	/* FP registers must be last (removed if not checked) */
+	{ "s0", "S0", 32, FPR },
+	{ "s1", "S1", 32, FPR },
+	{ "s2", "S2", 32, FPR },
+	{ "s3", "S3", 32, FPR },
+	{ "s4", "S4", 32, FPR },
+	{ "s5", "S5", 32, FPR },
+	{ "s6", "S6", 32, FPR },
+	{ "s7", "S7", 32, FPR },
+	{ "s8", "S8", 32, FPR },
+	{ "s9", "S9", 32, FPR },
+	{ "s10", "S10", 32, FPR },
+	{ "s11", "S11", 32, FPR },
+	{ "s12", "S12", 32, FPR },
+	{ "s13", "S13", 32, FPR },
+	{ "s14", "S14", 32, FPR },
+	{ "s15", "S15", 32, FPR },
+	{ "s16", "S16", 32, FPR },
+	{ "s17", "S17", 32, FPR },
+	{ "s18", "S18", 32, FPR },
+	{ "s19", "S19", 32, FPR },
+	{ "s20", "S20", 32, FPR },
+	{ "s21", "S21", 32, FPR },
+	{ "s22", "S22", 32, FPR },
+	{ "s23", "S23", 32, FPR },
+	{ "s24", "S24", 32, FPR },
+	{ "s25", "S25", 32, FPR },
+	{ "s26", "S26", 32, FPR },
+	{ "s27", "S27", 32, FPR },
+	{ "s28", "S28", 32, FPR },
+	{ "s29", "S29", 32, FPR },
+	{ "s30", "S30", 32, FPR },
+	{ "s31", "S31", 32, FPR },
 	{ 0 }
 };
+#define REG_MAX		50
 
 /**
  * Back-map from GDB indexes to validator indexes.
  */
 int *gdb_map;
 
-register_value_t state_store[4][17];			/** Actual storage of sim, GDB states. */
+register_value_t state_store[4][REG_MAX];		/** Actual storage of sim, GDB states. */
 register_value_t *iss_cur = state_store[0];		/** Current state of simulator. */
 register_value_t *iss_prv = state_store[1];		/** Previous state of simulator. */
 register_value_t *gdb_cur = state_store[2];		/** Current state of GDB. */
@@ -107,6 +141,7 @@ int cont = 0;
 int max_err = 0;
 int do_log = 0;
 int max_sync = 8;
+int check_fpr = 0;
 
 
 /* output */
@@ -161,6 +196,7 @@ void usage(const char *cmd) {
 		"-c, --continue		Continue if the co-simulation fails.\n"
 		"-C, --errors=N		Continue if the co-simulation fails at most N times.\n"
 		"-G, --debug		Display messages exchanged with GDB.\n"
+		"-f, --fpr			Also compare the VFP registers (s0 to s31).\n"
 	);
 }
 
@@ -188,9 +224,10 @@ void parse_args(int argc, char ** argv) {
 		{ "continue",		0,	NULL,	'c' },
 		{ "errors",			1,	NULL,	'C'	},
 		{ "debug",			0,	NULL,	'G' },
+		{ "fpr",			0,	NULL,	'f' },
 		{ NULL, 			0, 	NULL, 	0	}
 	};
-	char *optstring = "vhVlL:g:ircC:G";
+	char *optstring = "vhVlL:g:ircC:Gf";
 
 	/* parse argument */
 	while ((option = getopt_long(argc, argv, optstring, longopts, &longindex)) != -1)
@@ -206,12 +243,23 @@ void parse_args(int argc, char ** argv) {
 		case 'c':	cont = 1; break;
 		case 'C':	cont = 1; max_err = strtol(optarg, NULL, 10); break;
 		case 'G':	list_gdb = 1; break;
+		case 'f':	check_fpr = 1; break;
 		default:
 			fprintf(stderr, "ERROR: unknown option %c\n", optopt);
 			usage(argv[0]);
 			exit(1);
 		}
 
+	/* remove FP registers if not checked */
+	if(!check_fpr) {
+		int i;
+		for(i = 0; registers[i].gdb_name; i++)
+			if(registers[i].flags & FPR) {
+				registers[i].gdb_name = NULL;
+				break;
+			}
+	}
+
 	/* process free arguments */
 	if(optind < argc)
 		strncpy(exe_path, argv[optind], sizeof(exe_path));
@@ -311,6 +359,10 @@ void iss_init(void) {
 		fprintf(stderr, "ERROR: no more resources\n");
 		exit(2);
 	}
+#	ifdef ARM_FUSE
+	/* gdb steps one instruction at a time: no fused pair */
+	arm_fuse_enable(iss_state, 0);
+#	endif
 
 	/* make the simulator */
 	iss = arm_new_sim(iss_state, 0, exit_addr);
@@ -349,7 +401,7 @@ void iss_init(void) {
 					for(i = 0; registers[i].gdb_name; i++)
 						if(strcmp(registers[i].gliss_name, buf) == 0) {
 							registers[i].id = bank->id;
-							registers[i].idx = i;
+							registers[i].idx = j;
 							registers[i].flags |= DONE;
 							break;
 						}